@@ -68,14 +68,17 @@
 #define configTICK_RATE_HZ                       ((TickType_t)1000)
 #define configMAX_PRIORITIES                     ( 56 )
 #define configMINIMAL_STACK_SIZE                 ((uint16_t)128)
-#define configTOTAL_HEAP_SIZE                    ((size_t)15360)
+#define configTOTAL_HEAP_SIZE                    ((size_t)1024)
 #define configMAX_TASK_NAME_LEN                  ( 16 )
 #define configUSE_TRACE_FACILITY                 1
 #define configUSE_16_BIT_TICKS                   0
 #define configUSE_MUTEXES                        1
 #define configQUEUE_REGISTRY_SIZE                8
+#define configCHECK_FOR_STACK_OVERFLOW           2
 #define configUSE_RECURSIVE_MUTEXES              1
+#define configUSE_MALLOC_FAILED_HOOK             1
 #define configUSE_COUNTING_SEMAPHORES            1
+#define configGENERATE_RUN_TIME_STATS            1
 #define configUSE_PORT_OPTIMISED_TASK_SELECTION  0
 /* USER CODE BEGIN MESSAGE_BUFFER_LENGTH_TYPE */
 /* Defaults to size_t for backward compatibility, but can be changed
@@ -116,6 +119,7 @@ to exclude the API function. */
 #define INCLUDE_uxTaskGetStackHighWaterMark  1
 #define INCLUDE_xTaskGetCurrentTaskHandle    1
 #define INCLUDE_eTaskGetState                1
+#define INCLUDE_xTaskGetIdleTaskHandle       1
 
 /*
  * The CMSIS-RTOS V2 FreeRTOS wrapper is dependent on the heap implementation used
@@ -154,6 +158,12 @@ header file. */
 #define configASSERT( x ) if ((x) == 0) {taskDISABLE_INTERRUPTS(); for( ;; );}
 /* USER CODE END 1 */
 
+/* USER CODE BEGIN 2 */
+/* Definitions needed when configGENERATE_RUN_TIME_STATS is on */
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS configureTimerForRunTimeStats
+#define portGET_RUN_TIME_COUNTER_VALUE getRunTimeCounterValue
+/* USER CODE END 2 */
+
 /* Definitions that map the FreeRTOS port interrupt handlers to their CMSIS
 standard names. */
 #define vPortSVCHandler    SVC_Handler
@@ -165,6 +175,22 @@ standard names. */
 
 /* USER CODE BEGIN Defines */
 /* Section where parameter definitions can be added (for instance, to override default ones in FreeRTOS.h) */
+/* 调度事件跟踪 (Hardware/TRACE.c)，这些宏在 tasks.c / queue.c 内展开 */
+#if defined(__ICCARM__) || defined(__CC_ARM) || defined(__GNUC__)
+#include "TRACE.h"
+#if TRACE_ENABLE
+#define traceTASK_SWITCHED_IN()                 Trace_Event(TRACE_EV_TASK_IN, (uint8_t)pxCurrentTCB->uxTCBNumber, 0)
+#define traceTASK_SWITCHED_OUT()                Trace_Event(TRACE_EV_TASK_OUT, (uint8_t)pxCurrentTCB->uxTCBNumber, 0)
+#define traceMOVED_TASK_TO_READY_STATE(pxTCB)   Trace_Event(TRACE_EV_TASK_READY, (uint8_t)(pxTCB)->uxTCBNumber, 0)
+#define traceQUEUE_SEND(pxQueue)                Trace_Queue(TRACE_EV_QUEUE_SEND, (pxQueue)->uxQueueNumber, (pxQueue)->uxMessagesWaiting)
+#define traceQUEUE_SEND_FROM_ISR(pxQueue)       Trace_Queue(TRACE_EV_QUEUE_SEND, (pxQueue)->uxQueueNumber, (pxQueue)->uxMessagesWaiting)
+#define traceQUEUE_SEND_FAILED(pxQueue)         Trace_Queue(TRACE_EV_QUEUE_FULL, (pxQueue)->uxQueueNumber, (pxQueue)->uxMessagesWaiting)
+#define traceQUEUE_SEND_FROM_ISR_FAILED(pxQueue) Trace_Queue(TRACE_EV_QUEUE_FULL, (pxQueue)->uxQueueNumber, (pxQueue)->uxMessagesWaiting)
+#define traceQUEUE_RECEIVE(pxQueue)             Trace_Queue(TRACE_EV_QUEUE_RECV, (pxQueue)->uxQueueNumber, (pxQueue)->uxMessagesWaiting)
+#define traceQUEUE_RECEIVE_FROM_ISR(pxQueue)    Trace_Queue(TRACE_EV_QUEUE_RECV, (pxQueue)->uxQueueNumber, (pxQueue)->uxMessagesWaiting)
+#define traceBLOCKING_ON_QUEUE_RECEIVE(pxQueue) Trace_Queue(TRACE_EV_QUEUE_BLOCK, (pxQueue)->uxQueueNumber, 0)
+#endif
+#endif
 /* USER CODE END Defines */
 
 #endif /* FREERTOS_CONFIG_H */
@@ -37,6 +37,16 @@ extern "C" {
 #include "Line_Tracker.h"
 #include "usart.h"
 #include "Avoid.h"
+#include "TELEMETRY.h"
+#include "PROFILE.h"
+#include "MONITOR.h"
+#include "TRACE.h"
+#include "TIMEBASE.h"
+#include "LINE_CAPTURE.h"
+#include "ODOMETRY.h"
+#include "RECOVER.h"
+#include "MOTION.h"
+#include "VISION.h"
 /* USER CODE END Includes */
 
 /* Exported types ------------------------------------------------------------*/
@@ -24,7 +24,7 @@
 
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
-
+#include "TELEMETRY.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -52,6 +52,50 @@
 
 /* USER CODE END FunctionPrototypes */
 
+/* Hook prototypes */
+void configureTimerForRunTimeStats(void);
+unsigned long getRunTimeCounterValue(void);
+void vApplicationStackOverflowHook(xTaskHandle xTask, signed char *pcTaskName);
+void vApplicationMallocFailedHook(void);
+
+/* USER CODE BEGIN 1 */
+/* Functions needed when configGENERATE_RUN_TIME_STATS is on */
+/* 与驱动时间戳共用 TIM5 微秒时基 (TIMEBASE.h) */
+void configureTimerForRunTimeStats(void)
+{
+  Timebase_Init();
+}
+
+unsigned long getRunTimeCounterValue(void)
+{
+  return Timebase_Now_Us();
+}
+/* USER CODE END 1 */
+
+/* USER CODE BEGIN 4 */
+void vApplicationStackOverflowHook(xTaskHandle xTask, signed char *pcTaskName)
+{
+   /* Run time stack overflow checking is performed if
+   configCHECK_FOR_STACK_OVERFLOW is defined to 1 or 2. This hook function is
+   called if a stack overflow is detected. */
+  taskDISABLE_INTERRUPTS();
+  Telemetry_Panic_Dump(TLM_PANIC_STACK);
+  for(;;);
+}
+/* USER CODE END 4 */
+
+/* USER CODE BEGIN 5 */
+void vApplicationMallocFailedHook(void)
+{
+   /* vApplicationMallocFailedHook() will only be called if
+   configUSE_MALLOC_FAILED_HOOK is set to 1 in FreeRTOSConfig.h. It is a hook
+   function that will get called if a call to pvPortMalloc() fails. */
+  taskDISABLE_INTERRUPTS();
+  Telemetry_Panic_Dump(TLM_PANIC_MALLOC);
+  for(;;);
+}
+/* USER CODE END 5 */
+
 /* Private application code --------------------------------------------------*/
 /* USER CODE BEGIN Application */
 
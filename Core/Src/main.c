@@ -32,7 +32,13 @@
 
 /* Private define ------------------------------------------------------------*/
 /* USER CODE BEGIN PD */
+/* 速率组周期 (其余任务均为事件驱动，阻塞在各自的队列上) */
+#define CONTROL_PERIOD_MS   10      // MotorConfig: 循迹控制
+#define AVOID_PERIOD_MS     200     // ObstacleAvoidan: 超声波测距 (近于阈值时就地执行避障流程)
+                                    // Service: 遥测/跟踪发送 TLM_DRAIN_PERIOD_MS，运行监控 MON_PERIOD_MS
 
+/* RTOS 内存预算 (字节): 静态分配的任务栈、控制块、队列存储加上 FreeRTOS 堆 */
+#define RTOS_RAM_BUDGET     8192
 /* USER CODE END PD */
 
 /* Private macro -------------------------------------------------------------*/
@@ -48,109 +54,147 @@ TIM_HandleTypeDef htim2;
 TIM_HandleTypeDef htim3;
 TIM_HandleTypeDef htim4;
 TIM_HandleTypeDef htim5;
+TIM_HandleTypeDef htim8;
 TIM_HandleTypeDef htim9;
+DMA_HandleTypeDef hdma_tim8_up;
 
 UART_HandleTypeDef huart2;
 DMA_HandleTypeDef hdma_usart2_rx;
+DMA_HandleTypeDef hdma_usart2_tx;
 
-/* Definitions for defaultTask */
-osThreadId_t defaultTaskHandle;
-const osThreadAttr_t defaultTask_attributes = {
-  .name = "defaultTask",
-  .stack_size = 128 * 4,
-  .priority = (osPriority_t) osPriorityLow,
-};
 /* Definitions for SG90Config */
 osThreadId_t SG90ConfigHandle;
+uint32_t SG90ConfigBuffer[ 128 ];
+osStaticThreadDef_t SG90ConfigControlBlock;
 const osThreadAttr_t SG90Config_attributes = {
   .name = "SG90Config",
-  .stack_size = 128 * 4,
+  .cb_mem = &SG90ConfigControlBlock,
+  .cb_size = sizeof(SG90ConfigControlBlock),
+  .stack_mem = &SG90ConfigBuffer[0],
+  .stack_size = sizeof(SG90ConfigBuffer),
   .priority = (osPriority_t) osPriorityNormal6,
 };
 /* Definitions for MotorConfig */
 osThreadId_t MotorConfigHandle;
+uint32_t MotorConfigBuffer[ 256 ];
+osStaticThreadDef_t MotorConfigControlBlock;
 const osThreadAttr_t MotorConfig_attributes = {
   .name = "MotorConfig",
-  .stack_size = 256 * 4,
+  .cb_mem = &MotorConfigControlBlock,
+  .cb_size = sizeof(MotorConfigControlBlock),
+  .stack_mem = &MotorConfigBuffer[0],
+  .stack_size = sizeof(MotorConfigBuffer),
   .priority = (osPriority_t) osPriorityHigh,
 };
-/* Definitions for EncoderCap */
-osThreadId_t EncoderCapHandle;
-const osThreadAttr_t EncoderCap_attributes = {
-  .name = "EncoderCap",
-  .stack_size = 128 * 4,
-  .priority = (osPriority_t) osPriorityAboveNormal6,
-};
 /* Definitions for MVProcess */
 osThreadId_t MVProcessHandle;
+uint32_t MVProcessBuffer[ 256 ];
+osStaticThreadDef_t MVProcessControlBlock;
 const osThreadAttr_t MVProcess_attributes = {
   .name = "MVProcess",
-  .stack_size = 256 * 4,
+  .cb_mem = &MVProcessControlBlock,
+  .cb_size = sizeof(MVProcessControlBlock),
+  .stack_mem = &MVProcessBuffer[0],
+  .stack_size = sizeof(MVProcessBuffer),
   .priority = (osPriority_t) osPriorityAboveNormal4,
 };
-/* Definitions for PostureAcq */
-osThreadId_t PostureAcqHandle;
-const osThreadAttr_t PostureAcq_attributes = {
-  .name = "PostureAcq",
-  .stack_size = 256 * 4,
-  .priority = (osPriority_t) osPriorityAboveNormal2,
-};
-/* Definitions for StateSwitch */
-osThreadId_t StateSwitchHandle;
-const osThreadAttr_t StateSwitch_attributes = {
-  .name = "StateSwitch",
-  .stack_size = 128 * 4,
-  .priority = (osPriority_t) osPriorityAboveNormal,
-};
 /* Definitions for ObstacleAvoidan */
 osThreadId_t ObstacleAvoidanHandle;
+uint32_t ObstacleAvoidanBuffer[ 256 ];
+osStaticThreadDef_t ObstacleAvoidanControlBlock;
 const osThreadAttr_t ObstacleAvoidan_attributes = {
   .name = "ObstacleAvoidan",
-  .stack_size = 128 * 4,
-  .priority = (osPriority_t) osPriorityNormal4,
-};
-/* Definitions for DebugTask */
-osThreadId_t DebugTaskHandle;
-const osThreadAttr_t DebugTask_attributes = {
-  .name = "DebugTask",
-  .stack_size = 256 * 4,
-  .priority = (osPriority_t) osPriorityRealtime,
+  .cb_mem = &ObstacleAvoidanControlBlock,
+  .cb_size = sizeof(ObstacleAvoidanControlBlock),
+  .stack_mem = &ObstacleAvoidanBuffer[0],
+  .stack_size = sizeof(ObstacleAvoidanBuffer),
+  .priority = (osPriority_t) osPriorityAboveNormal6,
 };
 /* Definitions for OLEDDisplay */
 osThreadId_t OLEDDisplayHandle;
+uint32_t OLEDDisplayBuffer[ 128 ];
+osStaticThreadDef_t OLEDDisplayControlBlock;
 const osThreadAttr_t OLEDDisplay_attributes = {
   .name = "OLEDDisplay",
-  .stack_size = 128 * 4,
+  .cb_mem = &OLEDDisplayControlBlock,
+  .cb_size = sizeof(OLEDDisplayControlBlock),
+  .stack_mem = &OLEDDisplayBuffer[0],
+  .stack_size = sizeof(OLEDDisplayBuffer),
   .priority = (osPriority_t) osPriorityAboveNormal5,
 };
+/* Definitions for Service */
+osThreadId_t ServiceHandle;
+uint32_t ServiceBuffer[ 256 ];
+osStaticThreadDef_t ServiceControlBlock;
+const osThreadAttr_t Service_attributes = {
+  .name = "Service",
+  .cb_mem = &ServiceControlBlock,
+  .cb_size = sizeof(ServiceControlBlock),
+  .stack_mem = &ServiceBuffer[0],
+  .stack_size = sizeof(ServiceBuffer),
+  .priority = (osPriority_t) osPriorityBelowNormal,
+};
 /* Definitions for SG90Queue */
 osMessageQueueId_t SG90QueueHandle;
+uint8_t SG90QueueBuffer[ 4 * sizeof( uint32_t ) ];
+osStaticMessageQDef_t SG90QueueControlBlock;
 const osMessageQueueAttr_t SG90Queue_attributes = {
-  .name = "SG90Queue"
+  .name = "SG90Queue",
+  .cb_mem = &SG90QueueControlBlock,
+  .cb_size = sizeof(SG90QueueControlBlock),
+  .mq_mem = &SG90QueueBuffer,
+  .mq_size = sizeof(SG90QueueBuffer)
 };
 /* Definitions for MVQueue */
 osMessageQueueId_t MVQueueHandle;
+uint8_t MVQueueBuffer[ 8 * sizeof( _RXBUFF ) ];
+osStaticMessageQDef_t MVQueueControlBlock;
 const osMessageQueueAttr_t MVQueue_attributes = {
-  .name = "MVQueue"
+  .name = "MVQueue",
+  .cb_mem = &MVQueueControlBlock,
+  .cb_size = sizeof(MVQueueControlBlock),
+  .mq_mem = &MVQueueBuffer,
+  .mq_size = sizeof(MVQueueBuffer)
 };
 /* Definitions for MotorQueue */
 osMessageQueueId_t MotorQueueHandle;
+uint8_t MotorQueueBuffer[ 4 * sizeof( uint32_t ) ];
+osStaticMessageQDef_t MotorQueueControlBlock;
 const osMessageQueueAttr_t MotorQueue_attributes = {
-  .name = "MotorQueue"
+  .name = "MotorQueue",
+  .cb_mem = &MotorQueueControlBlock,
+  .cb_size = sizeof(MotorQueueControlBlock),
+  .mq_mem = &MotorQueueBuffer,
+  .mq_size = sizeof(MotorQueueBuffer)
 };
 /* Definitions for OLEDQueue */
 osMessageQueueId_t OLEDQueueHandle;
+uint8_t OLEDQueueBuffer[ 8 * sizeof( uint32_t ) ];
+osStaticMessageQDef_t OLEDQueueControlBlock;
 const osMessageQueueAttr_t OLEDQueue_attributes = {
-  .name = "OLEDQueue"
-};
-/* Definitions for EventGroup */
-osEventFlagsId_t EventGroupHandle;
-const osEventFlagsAttr_t EventGroup_attributes = {
-  .name = "EventGroup"
+  .name = "OLEDQueue",
+  .cb_mem = &OLEDQueueControlBlock,
+  .cb_size = sizeof(OLEDQueueControlBlock),
+  .mq_mem = &OLEDQueueBuffer,
+  .mq_size = sizeof(OLEDQueueBuffer)
 };
 /* USER CODE BEGIN PV */
 extern uint8_t Global_RxBuffer[USART_BUFFER_SIZE];
-static uint8_t DebugNum;
+
+/* 编译期检查内存预算，超出时报错 (Keil ARMCC5 不支持 _Static_assert) */
+#define RTOS_STATIC_RAM ( \
+    sizeof(SG90ConfigBuffer) + sizeof(SG90ConfigControlBlock) + \
+    sizeof(MotorConfigBuffer) + sizeof(MotorConfigControlBlock) + \
+    sizeof(MVProcessBuffer) + sizeof(MVProcessControlBlock) + \
+    sizeof(ObstacleAvoidanBuffer) + sizeof(ObstacleAvoidanControlBlock) + \
+    sizeof(OLEDDisplayBuffer) + sizeof(OLEDDisplayControlBlock) + \
+    sizeof(ServiceBuffer) + sizeof(ServiceControlBlock) + \
+    sizeof(SG90QueueBuffer) + sizeof(SG90QueueControlBlock) + \
+    sizeof(MVQueueBuffer) + sizeof(MVQueueControlBlock) + \
+    sizeof(MotorQueueBuffer) + sizeof(MotorQueueControlBlock) + \
+    sizeof(OLEDQueueBuffer) + sizeof(OLEDQueueControlBlock) + \
+    configTOTAL_HEAP_SIZE)
+typedef char rtos_ram_budget_check[(RTOS_STATIC_RAM <= RTOS_RAM_BUDGET) ? 1 : -1];
 /* USER CODE END PV */
 
 /* Private function prototypes -----------------------------------------------*/
@@ -165,16 +209,13 @@ static void MX_USART2_UART_Init(void);
 static void MX_TIM9_Init(void);
 static void MX_TIM5_Init(void);
 static void MX_I2C2_Init(void);
-void StartDefaultTask(void *argument);
+static void MX_TIM8_Init(void);
 void SG90TaskEntry(void *argument);
 void MotorTaskEntry(void *argument);
-void EncoderTaskEntry(void *argument);
 void MVTaskEntry(void *argument);
-void PostureCapTaskEntry(void *argument);
-void StateConTaskEntry(void *argument);
 void AvoidtaskEntry(void *argument);
-void DebugTaskEntry(void *argument);
 void OLEDTaskEntry(void *argument);
+void ServiceTaskEntry(void *argument);
 
 /* USER CODE BEGIN PFP */
 
@@ -223,7 +264,13 @@ int main(void)
   MX_TIM9_Init();
   MX_TIM5_Init();
   MX_I2C2_Init();
+  MX_TIM8_Init();
   /* USER CODE BEGIN 2 */
+  Timebase_Init();
+  Line_Capture_Init();
+  Odom_Init();
+  Telemetry_Init();
+  Profile_Init();
 
   /* USER CODE END 2 */
 
@@ -247,7 +294,7 @@ int main(void)
   SG90QueueHandle = osMessageQueueNew (4, sizeof(uint32_t), &SG90Queue_attributes);
 
   /* creation of MVQueue */
-  MVQueueHandle = osMessageQueueNew (8, sizeof(uint32_t), &MVQueue_attributes);
+  MVQueueHandle = osMessageQueueNew (8, sizeof(_RXBUFF), &MVQueue_attributes);
 
   /* creation of MotorQueue */
   MotorQueueHandle = osMessageQueueNew (4, sizeof(uint32_t), &MotorQueue_attributes);
@@ -257,47 +304,33 @@ int main(void)
 
   /* USER CODE BEGIN RTOS_QUEUES */
   /* add queues, ... */
+  // 队列编号供调度跟踪使用，必须在队列创建之后
+  Trace_Init();
   /* USER CODE END RTOS_QUEUES */
 
   /* Create the thread(s) */
-  /* creation of defaultTask */
-  defaultTaskHandle = osThreadNew(StartDefaultTask, NULL, &defaultTask_attributes);
-
   /* creation of SG90Config */
   SG90ConfigHandle = osThreadNew(SG90TaskEntry, NULL, &SG90Config_attributes);
 
   /* creation of MotorConfig */
   MotorConfigHandle = osThreadNew(MotorTaskEntry, NULL, &MotorConfig_attributes);
 
-  /* creation of EncoderCap */
-  EncoderCapHandle = osThreadNew(EncoderTaskEntry, NULL, &EncoderCap_attributes);
-
   /* creation of MVProcess */
   MVProcessHandle = osThreadNew(MVTaskEntry, NULL, &MVProcess_attributes);
 
-  /* creation of PostureAcq */
-  PostureAcqHandle = osThreadNew(PostureCapTaskEntry, NULL, &PostureAcq_attributes);
-
-  /* creation of StateSwitch */
-  StateSwitchHandle = osThreadNew(StateConTaskEntry, NULL, &StateSwitch_attributes);
-
   /* creation of ObstacleAvoidan */
   ObstacleAvoidanHandle = osThreadNew(AvoidtaskEntry, NULL, &ObstacleAvoidan_attributes);
 
-  /* creation of DebugTask */
-  DebugTaskHandle = osThreadNew(DebugTaskEntry, NULL, &DebugTask_attributes);
-
   /* creation of OLEDDisplay */
   OLEDDisplayHandle = osThreadNew(OLEDTaskEntry, NULL, &OLEDDisplay_attributes);
 
+  /* creation of Service */
+  ServiceHandle = osThreadNew(ServiceTaskEntry, NULL, &Service_attributes);
+
   /* USER CODE BEGIN RTOS_THREADS */
   /* add threads, ... */
   /* USER CODE END RTOS_THREADS */
 
-  /* Create the event(s) */
-  /* creation of EventGroup */
-  EventGroupHandle = osEventFlagsNew(&EventGroup_attributes);
-
   /* USER CODE BEGIN RTOS_EVENTS */
   /* add events, ... */
   /* USER CODE END RTOS_EVENTS */
@@ -604,19 +637,24 @@ static void MX_TIM5_Init(void)
 
   /* USER CODE END TIM5_Init 0 */
 
+  TIM_ClockConfigTypeDef sClockSourceConfig = {0};
   TIM_MasterConfigTypeDef sMasterConfig = {0};
-  TIM_OC_InitTypeDef sConfigOC = {0};
 
   /* USER CODE BEGIN TIM5_Init 1 */
 
   /* USER CODE END TIM5_Init 1 */
   htim5.Instance = TIM5;
-  htim5.Init.Prescaler = 0;
+  htim5.Init.Prescaler = 84-1;
   htim5.Init.CounterMode = TIM_COUNTERMODE_UP;
   htim5.Init.Period = 4294967295;
   htim5.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
   htim5.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
-  if (HAL_TIM_PWM_Init(&htim5) != HAL_OK)
+  if (HAL_TIM_Base_Init(&htim5) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  sClockSourceConfig.ClockSource = TIM_CLOCKSOURCE_INTERNAL;
+  if (HAL_TIM_ConfigClockSource(&htim5, &sClockSourceConfig) != HAL_OK)
   {
     Error_Handler();
   }
@@ -626,18 +664,55 @@ static void MX_TIM5_Init(void)
   {
     Error_Handler();
   }
-  sConfigOC.OCMode = TIM_OCMODE_PWM1;
-  sConfigOC.Pulse = 0;
-  sConfigOC.OCPolarity = TIM_OCPOLARITY_HIGH;
-  sConfigOC.OCFastMode = TIM_OCFAST_DISABLE;
-  if (HAL_TIM_PWM_ConfigChannel(&htim5, &sConfigOC, TIM_CHANNEL_1) != HAL_OK)
+  /* USER CODE BEGIN TIM5_Init 2 */
+
+  /* USER CODE END TIM5_Init 2 */
+
+}
+
+/**
+  * @brief TIM8 Initialization Function
+  * @param None
+  * @retval None
+  */
+static void MX_TIM8_Init(void)
+{
+
+  /* USER CODE BEGIN TIM8_Init 0 */
+
+  /* USER CODE END TIM8_Init 0 */
+
+  TIM_ClockConfigTypeDef sClockSourceConfig = {0};
+  TIM_MasterConfigTypeDef sMasterConfig = {0};
+
+  /* USER CODE BEGIN TIM8_Init 1 */
+
+  /* USER CODE END TIM8_Init 1 */
+  htim8.Instance = TIM8;
+  htim8.Init.Prescaler = 0;
+  htim8.Init.CounterMode = TIM_COUNTERMODE_UP;
+  htim8.Init.Period = 8400-1;
+  htim8.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+  htim8.Init.RepetitionCounter = 0;
+  htim8.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
+  if (HAL_TIM_Base_Init(&htim8) != HAL_OK)
   {
     Error_Handler();
   }
-  /* USER CODE BEGIN TIM5_Init 2 */
+  sClockSourceConfig.ClockSource = TIM_CLOCKSOURCE_INTERNAL;
+  if (HAL_TIM_ConfigClockSource(&htim8, &sClockSourceConfig) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  sMasterConfig.MasterOutputTrigger = TIM_TRGO_RESET;
+  sMasterConfig.MasterSlaveMode = TIM_MASTERSLAVEMODE_DISABLE;
+  if (HAL_TIMEx_MasterConfigSynchronization(&htim8, &sMasterConfig) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  /* USER CODE BEGIN TIM8_Init 2 */
 
-  /* USER CODE END TIM5_Init 2 */
-  HAL_TIM_MspPostInit(&htim5);
+  /* USER CODE END TIM8_Init 2 */
 
 }
 
@@ -739,11 +814,18 @@ static void MX_DMA_Init(void)
 
   /* DMA controller clock enable */
   __HAL_RCC_DMA1_CLK_ENABLE();
+  __HAL_RCC_DMA2_CLK_ENABLE();
 
   /* DMA interrupt init */
   /* DMA1_Stream5_IRQn interrupt configuration */
   HAL_NVIC_SetPriority(DMA1_Stream5_IRQn, 5, 0);
   HAL_NVIC_EnableIRQ(DMA1_Stream5_IRQn);
+  /* DMA1_Stream6_IRQn interrupt configuration */
+  HAL_NVIC_SetPriority(DMA1_Stream6_IRQn, 5, 0);
+  HAL_NVIC_EnableIRQ(DMA1_Stream6_IRQn);
+  /* DMA2_Stream1_IRQn interrupt configuration */
+  HAL_NVIC_SetPriority(DMA2_Stream1_IRQn, 5, 0);
+  HAL_NVIC_EnableIRQ(DMA2_Stream1_IRQn);
 
 }
 
@@ -788,35 +870,30 @@ static void MX_GPIO_Init(void)
 
   /*Configure GPIO pin : PD1 */
   GPIO_InitStruct.Pin = GPIO_PIN_1;
-  GPIO_InitStruct.Mode = GPIO_MODE_INPUT;
+  GPIO_InitStruct.Mode = GPIO_MODE_IT_RISING_FALLING;
   GPIO_InitStruct.Pull = GPIO_NOPULL;
   HAL_GPIO_Init(GPIOD, &GPIO_InitStruct);
 
+  /* EXTI interrupt init*/
+  HAL_NVIC_SetPriority(EXTI1_IRQn, 5, 0);
+  HAL_NVIC_EnableIRQ(EXTI1_IRQn);
+
 /* USER CODE BEGIN MX_GPIO_Init_2 */
 /* USER CODE END MX_GPIO_Init_2 */
 }
 
 /* USER CODE BEGIN 4 */
-
-/* USER CODE END 4 */
-
-/* USER CODE BEGIN Header_StartDefaultTask */
 /**
-  * @brief  Function implementing the defaultTask thread.
-  * @param  argument: Not used
-  * @retval None
+  * @brief  EXTI 回调: PD1 为 HC-SR04 Echo，两个边沿都记录时间戳
   */
-/* USER CODE END Header_StartDefaultTask */
-void StartDefaultTask(void *argument)
+void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
 {
-  /* USER CODE BEGIN 5 */
-  /* Infinite loop */
-  for(;;)
+  if (GPIO_Pin == HCSR04_ECHO_PIN)
   {
-    osDelay(1);
+    HCSR04_Echo_Edge();
   }
-  /* USER CODE END 5 */
 }
+/* USER CODE END 4 */
 
 /* USER CODE BEGIN Header_SG90TaskEntry */
 /**
@@ -850,40 +927,24 @@ void SG90TaskEntry(void *argument)
 void MotorTaskEntry(void *argument)
 {
   /* USER CODE BEGIN MotorTaskEntry */
+  // 陀螺仪在电机启动前、车身静止时初始化并校准零偏 (约 0.5s)，循迹前馈和航迹推算第一拍起就用校准后的值
+	MPU6050_Init();
+	MPU6050_Calibrate_Z();
 	Motor_Start();
   //static MotorConfigStr MotorConfigAttri;
+  uint32_t tick = osKernelGetTickCount();
   /* Infinite loop */
   for(;;)
   {
 		Line_Tracker_PID_Action();
-	    osDelay(10); 
+    // 固定 10ms 周期。路口等待 / 避障挂起之后时刻已过，从当前时刻重新对齐，不补跑
+    tick += CONTROL_PERIOD_MS;
+    if (osDelayUntil(tick) != osOK) tick = osKernelGetTickCount();
   }
   
   /* USER CODE END MotorTaskEntry */
 }
 
-/* USER CODE BEGIN Header_EncoderTaskEntry */
-/**
-* @brief Function implementing the DistanceCap thread.
-* @param argument: Not used
-* @retval None
-*/
-/* USER CODE END Header_EncoderTaskEntry */
-void EncoderTaskEntry(void *argument)
-{
-  /* USER CODE BEGIN EncoderTaskEntry */
-  /* Infinite loop */
-  for(;;)
-  {
-    if(HCSR04_Read_Distance() <= OBSTACLE_DIST_CM)//小于阈值5.0
-    {
-      osEventFlagsSet(EventGroupHandle, OBSTACLE_AVOIDANCE_FLAG);
-    }
-    osDelay(200);
-  }
-  /* USER CODE END EncoderTaskEntry */
-}
-
 /* USER CODE BEGIN Header_MVTaskEntry */
 /**
 * @brief Function implementing the MVProcess thread.
@@ -900,9 +961,15 @@ void MVTaskEntry(void *argument)
   {
     if(osMessageQueueGet(MVQueueHandle, pToCurrentRxBufStructure, NULL, osWaitForever) == osOK)
     {
-      if(USART_FrameProcess(pToCurrentRxBufStructure) == 1)
+      PROF_BEGIN(PROF_USART_FRAME);
+      uint8_t frame_ok = USART_FrameProcess(pToCurrentRxBufStructure);
+      PROF_END(PROF_USART_FRAME);
+      if(frame_ok == 1)
       {
-        //DebugNum = 0x70;
+        // K230 结果写入视觉缓存，路口直接取用 (VISION.c)
+        const uint8_t *frame;
+        uint16_t frame_len = USART_Get_Frame(&frame);
+        Vision_Parse_Frame(frame, frame_len, pToCurrentRxBufStructure->time_us);
       }
       else
       {
@@ -913,42 +980,6 @@ void MVTaskEntry(void *argument)
   /* USER CODE END MVTaskEntry */
 }
 
-/* USER CODE BEGIN Header_PostureCapTaskEntry */
-/**
-* @brief Function implementing the PostureAcq thread.
-* @param argument: Not used
-* @retval None
-*/
-/* USER CODE END Header_PostureCapTaskEntry */
-void PostureCapTaskEntry(void *argument)
-{
-  /* USER CODE BEGIN PostureCapTaskEntry */
-  /* Infinite loop */
-  for(;;)
-  {
-    osDelay(osWaitForever);
-  }
-  /* USER CODE END PostureCapTaskEntry */
-}
-
-/* USER CODE BEGIN Header_StateConTaskEntry */
-/**
-* @brief Function implementing the StateSwitch thread.
-* @param argument: Not used
-* @retval None
-*/
-/* USER CODE END Header_StateConTaskEntry */
-void StateConTaskEntry(void *argument)
-{
-  /* USER CODE BEGIN StateConTaskEntry */
-  /* Infinite loop */
-  for(;;)
-  {
-    osDelay(osWaitForever);
-  }
-  /* USER CODE END StateConTaskEntry */
-}
-
 /* USER CODE BEGIN Header_AvoidtaskEntry */
 /**
 * @brief Function implementing the ObstacleAvoidan thread.
@@ -959,44 +990,22 @@ void StateConTaskEntry(void *argument)
 void AvoidtaskEntry(void *argument)
 {
   /* USER CODE BEGIN AvoidtaskEntry */
-	MPU6050_Init();
-	MPU6050_Calibrate_Z();
+  uint32_t tick = osKernelGetTickCount();
   /* Infinite loop */
   for(;;)
   {
-    if(osEventFlagsWait(EventGroupHandle, OBSTACLE_AVOIDANCE_FLAG, osFlagsWaitAll, osWaitForever) == OBSTACLE_AVOIDANCE_FLAG)
+    // 超声波测距 (原 EncoderCap 任务) 写入占据栅格，前方通道受阻时直接执行避障流程，不再经事件组转交
+    if(Obstacle_Detect())
     {
       Run_Obstacle_Avoidance();
-	  osEventFlagsClear(EventGroupHandle, OBSTACLE_AVOIDANCE_FLAG);
+      tick = osKernelGetTickCount();
     }
+    tick += AVOID_PERIOD_MS;
+    if (osDelayUntil(tick) != osOK) tick = osKernelGetTickCount();
   }
   /* USER CODE END AvoidtaskEntry */
 }
 
-/* USER CODE BEGIN Header_DebugTaskEntry */
-/**
-* @brief Function implementing the DebugTask thread.
-* @param argument: Not used
-* @retval None
-*/
-/* USER CODE END Header_DebugTaskEntry */
-void DebugTaskEntry(void *argument)
-{
-  /* USER CODE BEGIN DebugTaskEntry */
-  DebugNum = 0x11;
-  /* Infinite loop */
-  for(;;)
-  {
-//    OLED_DispString(1,1,"I LOVE U",Size8x16);
-//	OLED_DispUNum(1,1,123,Size8x16);
-////	OLED_DispUNum(2,1,2,Size8x16);
-	  
-    DEBUG_USART_TRANSMIT('0');
-    osDelay(1000);
-  }
-  /* USER CODE END DebugTaskEntry */
-}
-
 /* USER CODE BEGIN Header_OLEDTaskEntry */
 /**
 * @brief Function implementing the OLEDDisplay thread.
@@ -1019,6 +1028,45 @@ void OLEDTaskEntry(void *argument)
   /* USER CODE END OLEDTaskEntry */
 }
 
+/* USER CODE BEGIN Header_ServiceTaskEntry */
+/**
+* @brief Function implementing the Service thread.
+* @param argument: Not used
+* @retval None
+*/
+/* USER CODE END Header_ServiceTaskEntry */
+void ServiceTaskEntry(void *argument)
+{
+  /* USER CODE BEGIN ServiceTaskEntry */
+  uint32_t tick = osKernelGetTickCount();
+  uint32_t monitor_tick = tick;
+  /* Infinite loop */
+  for(;;)
+  {
+    // 调度跟踪快照导出期间独占串口，遥测记录暂时积压 (积压过多时丢弃最旧的)
+    if (!Trace_Drain())
+    {
+      // 后台发送遥测记录 (DMA，非阻塞)
+      Telemetry_Drain();
+      // 周期发送热点路径耗时统计 (文本行，以 "PROF" 开头)
+      Profile_Report();
+      // 绕行结束后发送一次耗时报告 (文本行，以 "AVOID" 开头)
+      Avoid_Report();
+      // 找线结束后发送一次报告 (文本行，以 "RECOVER" 开头)
+      Recover_Report();
+    }
+    // 任务 CPU 占用 / 栈余量 / 堆 / 队列统计，写入遥测服务记录
+    if (tick - monitor_tick >= MON_PERIOD_MS)
+    {
+      monitor_tick += MON_PERIOD_MS;
+      Monitor_Sample();
+    }
+    tick += TLM_DRAIN_PERIOD_MS;
+    if (osDelayUntil(tick) != osOK) tick = osKernelGetTickCount();
+  }
+  /* USER CODE END ServiceTaskEntry */
+}
+
 /**
   * @brief  Period elapsed callback in non blocking mode
   * @note   This function is called  when TIM1 interrupt took place, inside
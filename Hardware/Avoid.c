@@ -1,21 +1,111 @@
 #include "Avoid.h"
+#include "TELEMETRY.h"
+#include "TIMEBASE.h"
+#include "ODOMETRY.h"
+#include "SCAN.h"
+#include "GRID.h"
+#include "RECOVER.h"
+#include "usart.h"
+#include "stdio.h"
+#include "math.h"
 
-/* 简单的微秒级延时系数 (根据主频调整) */
-// STM32F4 (168MHz/84MHz) 粗略估算，如果不准可以微调
-#define US_DELAY_MULT 50 
+#define HCSR04_RISE_TIMEOUT_US  5000    // Trig 后 Echo 变高的最长等待 (正常约 0.5ms)
+#define HCSR04_ECHO_TIMEOUT_US  30000   // Echo 高电平上限，约 5m；无障碍时模块约 38ms 后才拉低
 /* 传感器引脚读取宏 (保持不变) */
 #define READ_L2  (HAL_GPIO_ReadPin(LINE_TRACKER_L2_GPIO_PORT, LINE_TRACKER_L2_GPIO_PIN) == GPIO_PIN_RESET)
 #define READ_L1  (HAL_GPIO_ReadPin(LINE_TRACKER_L1_GPIO_PORT, LINE_TRACKER_L1_GPIO_PIN) == GPIO_PIN_RESET)
 #define READ_R1  (HAL_GPIO_ReadPin(LINE_TRACKER_R1_GPIO_PORT, LINE_TRACKER_R1_GPIO_PIN) == GPIO_PIN_RESET)
 #define READ_R2  (HAL_GPIO_ReadPin(LINE_TRACKER_R2_GPIO_PORT, LINE_TRACKER_R2_GPIO_PIN) == GPIO_PIN_RESET)
-/**
- * @brief 简单的微秒延时 (阻塞式)
+
+/* ================= 绕行规划参数 ================= */
+#define AVOID_SIDE              1.0f    // 默认绕行方向 (不扫描或两侧相同时): 1 左绕, -1 右绕
+#define AVOID_STEP_MS           20      // 规划 / 控制周期 (切出段含一次测距，最长约 35ms)
+#define AVOID_SPEED             25      // 巡航 PWM
+#define AVOID_SPEED_SLOW        18      // 倒车 PWM
+#define AVOID_SCAN_SPEED        12      // 扫描期间减速到的 PWM
+#define AVOID_DECEL_STEP        1       // 扫描期间每个控制周期减少的 PWM
+#define AVOID_HEADING_KP        1.0f    // 扫描 / 倒车段航向误差 (deg) -> 差速 PWM
+#define AVOID_TURN_MAX          20      // 扫描 / 倒车段差速上限
+#define AVOID_CAR_HALF_W_M      0.09f   // 车宽的一半
+#define AVOID_TRACK_M           0.150f  // 轮距，曲率 -> 左右轮速比
+#define AVOID_MARGIN_M          0.06f   // 与障碍物保持的余量
+#define AVOID_DEFAULT_HALF_W_M  0.05f   // 规划初始假设的半宽，切出过程中按回波点加大
+#define AVOID_MAX_HALF_W_M      0.40f   // 半宽上限
+#define AVOID_DEPTH_M           0.15f   // 障碍物纵深 (前向超声波测不到，按赛道障碍物尺寸配置)
+#define AVOID_EDGE_JUMP_CM      15.0f   // 测距突增超过该值视为扫过了障碍物边缘
+#define AVOID_MIN_CLEAR_M       0.25f   // 切出曲线需要的最小纵向距离，不足时先倒车
+#define AVOID_MIN_ARC_M         0.15f   // 切出曲线的最短纵向长度
+#define AVOID_RETURN_SLOPE      1.0f    // 切回曲线的最大斜率 (tan 45°)
+#define AVOID_LOOKAHEAD_M       0.10f   // 纯追踪前视距离，过大会切弯 (短切出曲线上横向偏移不足)
+#define AVOID_KAPPA_MAX         10.0f   // 曲率上限 (1/m)，内侧轮不反转: < 2 / AVOID_TRACK_M
+#define AVOID_ALIGN_DEG         8.0f    // 切回段压线且航向误差小于该值即交还循迹
+#define AVOID_SONAR_STEPS       3       // 切出段以外每隔几个控制周期测一次距 (写入占据栅格)
+#define AVOID_MAX_PASS_M        1.2f    // 越过段终点距起点的上限 (连续障碍物时向前延长)
+#define AVOID_TIMEOUT_MS        6000u   // 整个绕行的超时
+#define AVOID_DEG2RAD           0.017453293f
+
+/*
+ * 绕行路径 (以触发时位姿为原点，x 向前，y 向绕行一侧为正):
+ *   y_ref(x) = 0                               x <= x0
+ *            = Y * S((x - x0) / (x1 - x0))     x0 < x < x1   切出
+ *            = Y                               x1 <= x <= x2 越过
+ *            = Y * (1 - S((x - x2) / (x3 - x2)))  x2 < x < x3 切回
+ *            = 0                               x >= x3
+ * S(u) = 10u^3 - 15u^4 + 6u^5，两端一阶、二阶导数为 0: 各段衔接处航向和曲率都连续，不需要停车转向
+ * x1 取障碍物前沿，x2 = 前沿 + 纵深 + 余量；Y 由扫描得到的障碍物边缘决定，没扫到边缘时在切出过程中按测距更新
+ * 以上为局部坐标 (触发时的位姿为原点)；占据栅格在里程计坐标系，查询时按原点位姿换算。
+ * 行驶中剩余路径被栅格中的障碍物挡住时就地修正 (加大 Y 或延长越过段)，连续多个障碍物也不停车
  */
-static void Delay_us(uint32_t us)
+typedef enum
 {
-    uint32_t i = us * US_DELAY_MULT;
-    while(i--);
-}
+    AVOID_LEG_SCAN = 0,     // 减速直行，舵机扫描选择绕行方向
+    AVOID_LEG_BACK,         // 太近，先倒车
+    AVOID_LEG_PATH,         // 沿绕行路径行驶
+    AVOID_LEG_RECOVER,      // 走完路径仍未压线，找线 (RECOVER.c)
+    AVOID_LEG_DONE
+} AVOID_LEG_E;
+
+typedef struct
+{
+    uint8_t leg;            // 当前段 (AVOID_LEG_E)
+    uint8_t edge_seen;      // 已测到障碍物边缘，Y 不再更新
+    float side;             // 1 左绕, -1 右绕
+    float obst_x;           // 障碍物前沿 x (m)
+    float y_off;            // 路径横向偏移 Y (m，不带方向)
+    float x0, x1, x2, x3;   // 路径分段点
+    float last_range_cm;    // 上一次打到障碍物的测距
+    float last_hit_y;       // 上一次回波点朝绕行一侧的横向位置 (m)
+    float ox, oy, oyaw;     // 局部坐标原点在里程计坐标系中的位姿
+    float oc, os;           // cos / sin(oyaw)
+    float odist;            // 原点处的累计路程
+    uint8_t sonar_cnt;      // 测距间隔计数
+    uint8_t replans;        // 按栅格修正路径的次数
+} AVOID_PLAN_T;
+
+typedef struct
+{
+    uint32_t count;         // 累计绕行次数
+    uint32_t duration_ms;   // 从挂起循迹到交还循迹的时间
+    uint16_t dist_cm;       // 触发时障碍物距离
+    uint16_t half_w_cm;     // 测得的半宽，0 表示未测到边缘
+    uint16_t path_cm;       // 绕行路程
+    uint16_t min_v_cms;     // 沿路径行驶时的最低车速 (cm/s)
+    int8_t side;            // 1 左绕, -1 右绕
+    uint8_t replans;        // 按栅格修正路径的次数
+    uint8_t blocked;        // 扫描结果: bit0 左侧受阻, bit1 右侧受阻
+    uint8_t leg;            // 结束时所在段: AVOID_LEG_RECOVER 为找线失败，其余非 AVOID_LEG_DONE 为超时
+} AVOID_REPORT_T;
+
+static AVOID_REPORT_T avoid_report;
+static volatile uint8_t avoid_report_pending = 0;
+
+static float hcsr04_last_cm = 999.0f;   // 最近一次测距结果，供遥测记录
+static uint32_t hcsr04_last_us = 0;     // 该次测距对应的时刻 (声波到达障碍物，TIMEBASE 微秒)
+static uint32_t hcsr04_trig_us = 0;     // Trig 脉冲结束时刻
+static volatile uint32_t hcsr04_rise_us = 0;    // Echo 上升沿 (中断中记录)
+static volatile uint32_t hcsr04_fall_us = 0;    // Echo 下降沿 (中断中记录)
+static volatile uint8_t hcsr04_edges = 0;       // Trigger 之后已记录的边沿: 0 无, 1 上升沿, 2 上升沿和下降沿
+static uint8_t hcsr04_busy = 0;         // 已触发、结果尚未取走
 
 /**
  * @brief 初始化函数
@@ -28,112 +118,502 @@ void Obstacle_Init(void)
 }
 
 /**
- * @brief 读取超声波距离 (cm)
- * @return float 距离，如果超时返回 999.0
+ * @brief 前方测距写入占据栅格，车宽的通道内 OBSTACLE_DIST_CM 以内有占据格即返回 1
+ * 不再只看单次测距: 偶发的假回波会被之后穿过该格的测距清掉，之前扫到的其他障碍物也会触发
  */
-float HCSR04_Read_Distance(void)
+uint8_t Obstacle_Detect(void)
+{
+    ODOM_POSE_T pose;
+    float r = HCSR04_Read_Distance();
+
+    Odom_Copy(&pose);
+    Grid_Insert(&pose, 0.0f, r, HCSR04_Get_Last_Time_Us());
+    return Grid_Corridor_Free(pose.x, pose.y, pose.yaw, OBSTACLE_DIST_CM * 0.01f, AVOID_CAR_HALF_W_M) <
+           OBSTACLE_DIST_CM * 0.01f;
+}
+
+/**
+ * @brief 发出一次 Trig 脉冲，回波由 Echo 的外部中断记录，之后用 HCSR04_Poll 取结果
+ */
+void HCSR04_Trigger(void)
 {
-    uint32_t local_count = 0;
-    uint32_t timeout = 0;
+    hcsr04_edges = 0;
 
-    // 1. 发送 Trig 脉冲 (至少 10us 高电平)
+    // 至少 10us 高电平
     HAL_GPIO_WritePin(HCSR04_TRIG_PORT, HCSR04_TRIG_PIN, GPIO_PIN_SET);
-    Delay_us(15);
+    Timebase_Delay_Us(15);
     HAL_GPIO_WritePin(HCSR04_TRIG_PORT, HCSR04_TRIG_PIN, GPIO_PIN_RESET);
+    hcsr04_trig_us = Timebase_Now_Us();
+    hcsr04_busy = 1;
+}
+
+/**
+ * @brief Echo 边沿中断 (PD1 上升 / 下降沿)，只记 TIM5 时间戳
+ * 上一次测量超时后模块可能仍拉高 Echo，Trigger 之后先看到的下降沿没有配对的上升沿，丢弃
+ */
+void HCSR04_Echo_Edge(void)
+{
+    uint32_t now = Timebase_Now_Us();
+
+    if (HAL_GPIO_ReadPin(HCSR04_ECHO_PORT, HCSR04_ECHO_PIN) == GPIO_PIN_SET)
+    {
+        hcsr04_rise_us = now;
+        hcsr04_edges = 1;
+    }
+    else if (hcsr04_edges == 1)
+    {
+        hcsr04_fall_us = now;
+        hcsr04_edges = 2;
+    }
+}
+
+/**
+ * @brief 查询 HCSR04_Trigger 发起的测距，不等待
+ * @return 1 已有结果 (写入 *cm，超时为 999.0)，0 回波尚未结束
+ */
+uint8_t HCSR04_Poll(float *cm)
+{
+    uint8_t edges = hcsr04_edges;
+
+    if (!hcsr04_busy)
+    {
+        *cm = hcsr04_last_cm;
+        return 1;
+    }
+
+    if (edges == 2)
+    {
+        // 公式: 距离 = 时间(us) * 0.034cm/us / 2
+        // 0.017 是理论值。如果发现测距不准（比如实际10cm测出20cm），请修改这个系数
+        // 测量时刻取回波中点，即声波到达障碍物的时刻
+        uint32_t t_rise = hcsr04_rise_us;
+        uint32_t t_fall = hcsr04_fall_us;
+
+        hcsr04_last_cm = (float)(t_fall - t_rise) * 0.017f;
+        hcsr04_last_us = t_rise + (t_fall - t_rise) / 2;
+    }
+    else if (edges == 0 && Timebase_Elapsed_Us(hcsr04_trig_us) > HCSR04_RISE_TIMEOUT_US)
+    {
+        hcsr04_last_cm = 999.0f;    // 超时未响应
+        hcsr04_last_us = hcsr04_trig_us;
+    }
+    else if (edges == 1 && Timebase_Elapsed_Us(hcsr04_rise_us) > HCSR04_ECHO_TIMEOUT_US)
+    {
+        hcsr04_last_cm = 999.0f;    // 超出量程
+        hcsr04_last_us = hcsr04_rise_us;
+    }
+    else
+    {
+        return 0;
+    }
+
+    hcsr04_busy = 0;
+    *cm = hcsr04_last_cm;
+    return 1;
+}
+
+/**
+ * @brief 读取超声波距离 (cm)，等到回波结束才返回 (无回波时约 35ms)
+ * @return float 距离，如果超时返回 999.0
+ */
+float HCSR04_Read_Distance(void)
+{
+    float cm;
+
+    HCSR04_Trigger();
+    while (!HCSR04_Poll(&cm))
+    {
+    }
+    return cm;
+}
+
+/**
+ * @brief 返回最近一次测距结果 (cm)，不触发新的测量
+ */
+float HCSR04_Get_Last_Distance(void)
+{
+    return hcsr04_last_cm;
+}
+
+/**
+ * @brief 返回最近一次测距的时间戳 (TIMEBASE 微秒)，与当前时间相减即数据年龄
+ */
+uint32_t HCSR04_Get_Last_Time_Us(void)
+{
+    return hcsr04_last_us;
+}
+
+/**
+ * @brief 里程计位姿 -> 局部位姿 (触发时位姿为原点)
+ */
+static void Avoid_To_Local(const AVOID_PLAN_T *plan, const ODOM_POSE_T *w, ODOM_POSE_T *l)
+{
+    float dx = w->x - plan->ox;
+    float dy = w->y - plan->oy;
+
+    *l = *w;
+    l->x = plan->oc * dx + plan->os * dy;
+    l->y = -plan->os * dx + plan->oc * dy;
+    l->yaw = w->yaw - plan->oyaw;
+    l->dist = w->dist - plan->odist;
+}
+
+/**
+ * @brief 局部坐标点 -> 里程计坐标系 (查询占据栅格用)
+ */
+static void Avoid_To_World(const AVOID_PLAN_T *plan, float lx, float ly, float *wx, float *wy)
+{
+    *wx = plan->ox + plan->oc * lx - plan->os * ly;
+    *wy = plan->oy + plan->os * lx + plan->oc * ly;
+}
+
+/**
+ * @brief 五次平滑阶跃 S(u)，u 限制在 [0, 1]
+ */
+static float Avoid_Smooth(float u)
+{
+    if (u <= 0.0f) return 0.0f;
+    if (u >= 1.0f) return 1.0f;
+    return u * u * u * (10.0f + u * (-15.0f + 6.0f * u));
+}
+
+/**
+ * @brief 路径在 x 处的横向位置 (带方向)
+ */
+static float Avoid_Path_Y(const AVOID_PLAN_T *plan, float x)
+{
+    float y;
+
+    if (x <= plan->x2) y = plan->y_off * Avoid_Smooth((x - plan->x0) / (plan->x1 - plan->x0));
+    else y = plan->y_off * (1.0f - Avoid_Smooth((x - plan->x2) / (plan->x3 - plan->x2)));
+    return plan->side * y;
+}
+
+/**
+ * @brief 从当前位置按 plan->side / y_off 生成绕行路径
+ */
+static void Avoid_Plan_Path(AVOID_PLAN_T *plan, const ODOM_POSE_T *pose)
+{
+    plan->x0 = pose->x;
+    plan->x1 = plan->obst_x;
+    if (plan->x1 - plan->x0 < AVOID_MIN_ARC_M) plan->x1 = plan->x0 + AVOID_MIN_ARC_M;
+    plan->x2 = plan->x1 + AVOID_DEPTH_M + AVOID_MARGIN_M;
+    // S(u) 最大斜率 15/8，按切回斜率上限取切回长度
+    plan->x3 = plan->x2 + 1.875f * plan->y_off / AVOID_RETURN_SLOPE;
+    plan->leg = AVOID_LEG_PATH;
+}
+
+/**
+ * @brief 离障碍物够远则生成路径，否则先倒车
+ */
+static void Avoid_Plan_Start(AVOID_PLAN_T *plan, const ODOM_POSE_T *pose)
+{
+    if (plan->obst_x - pose->x < AVOID_MIN_CLEAR_M) plan->leg = AVOID_LEG_BACK;
+    else Avoid_Plan_Path(plan, pose);
+}
+
+/**
+ * @brief 按扫描剖面选择绕行方向和横向偏移:
+ *        只有一侧受阻走另一侧，否则走边缘较近 (Y 较小、路径较短) 的一侧；障碍物前沿取扫描到的最近回波
+ */
+static void Avoid_Plan_Scan(AVOID_PLAN_T *plan)
+{
+    SCAN_RESULT_T res;
+    uint8_t s;
+
+    Scan_Analyze(plan->obst_x, AVOID_DEPTH_M, 2.0f * (AVOID_CAR_HALF_W_M + AVOID_MARGIN_M), &res);
+    avoid_report.blocked = 0;
+    if (res.points == 0) return;
+
+    avoid_report.blocked = (uint8_t)(res.blocked[0] | (res.blocked[1] << 1));
+    if (res.blocked[0] != res.blocked[1]) s = res.blocked[0] ? 1 : 0;
+    else if (res.edge[0] < res.edge[1]) s = 0;
+    else if (res.edge[1] < res.edge[0]) s = 1;
+    else s = (AVOID_SIDE > 0.0f) ? 0 : 1;
+
+    plan->side = (s == 0) ? 1.0f : -1.0f;
+    plan->obst_x = res.front_x;
+    plan->last_hit_y = (res.edge[s] > AVOID_MAX_HALF_W_M) ? AVOID_MAX_HALF_W_M : res.edge[s];
+    plan->y_off = plan->last_hit_y + AVOID_CAR_HALF_W_M + AVOID_MARGIN_M;
+    // 扫到边缘后不再在切出段测距；回波延续到扫描尽头时仍边走边测
+    plan->edge_seen = !res.open_end[s];
+}
+
+/**
+ * @brief 保持原线方向 (航向 0) 直行，速度可为负
+ */
+static void Avoid_Hold_Heading(const ODOM_POSE_T *pose, int speed, int *left, int *right)
+{
+    int turn = (int)(AVOID_HEADING_KP * -pose->yaw);
+
+    if (turn > AVOID_TURN_MAX) turn = AVOID_TURN_MAX;
+    if (turn < -AVOID_TURN_MAX) turn = -AVOID_TURN_MAX;
+    *left = speed - turn;
+    *right = speed + turn;
+}
+
+/**
+ * @brief 沿路径测距写入占据栅格；切出段还按回波点加大 Y: 仍能打到障碍物说明它至少延伸到回波点，
+ *        距离突增 (或超量程) 说明声波已扫过边缘，上一个回波点即边缘，之后不再更新
+ */
+static void Avoid_Plan_Measure(AVOID_PLAN_T *plan, const ODOM_POSE_T *pose)
+{
+    float r, need;
+    uint8_t cut_out = (!plan->edge_seen && pose->x < plan->x1);
+
+    // 切出段每拍测距，其余时候隔几拍测一次，只写入占据栅格供 Avoid_Plan_Check 使用
+    if (!cut_out && ++plan->sonar_cnt < AVOID_SONAR_STEPS) return;
+    plan->sonar_cnt = 0;
+    r = HCSR04_Read_Distance();
+    Grid_Insert(Odom_Get(), 0.0f, r, HCSR04_Get_Last_Time_Us());
+    if (!cut_out) return;
+
+    if (r >= 999.0f || r > plan->last_range_cm + AVOID_EDGE_JUMP_CM)
+    {
+        plan->edge_seen = 1;
+        return;
+    }
+    plan->last_range_cm = r;
+    plan->last_hit_y = plan->side * (pose->y + r * 0.01f * sinf(pose->yaw * AVOID_DEG2RAD));
+
+    need = plan->last_hit_y;
+    if (need > AVOID_MAX_HALF_W_M) need = AVOID_MAX_HALF_W_M;
+    need += AVOID_CAR_HALF_W_M + AVOID_MARGIN_M;
+    if (need > plan->y_off)
+    {
+        plan->y_off = need;
+        plan->x3 = plan->x2 + 1.875f * plan->y_off / AVOID_RETURN_SLOPE;
+    }
+}
 
-    // 2. 等待 Echo 变高 (超时处理)
-    timeout = 100000;
-    while(HAL_GPIO_ReadPin(HCSR04_ECHO_PORT, HCSR04_ECHO_PIN) == GPIO_PIN_RESET)
+/**
+ * @brief 在占据栅格中检查剩余路径，车身两侧各留半个余量
+ * @return 第一个受阻处的 x，畅通时返回负数
+ */
+static float Avoid_Path_Blocked(const AVOID_PLAN_T *plan, float x_from)
+{
+    float half = AVOID_CAR_HALF_W_M + 0.5f * AVOID_MARGIN_M;
+    float x, l, wx, wy;
+
+    for (x = x_from + GRID_CELL_M; x <= plan->x3; x += 0.5f * GRID_CELL_M)
     {
-        if(timeout-- == 0) return 999.0f; // 超时未响应
+        float y = Avoid_Path_Y(plan, x);
+        for (l = -half; l <= half + 0.001f; l += 0.5f * GRID_CELL_M)
+        {
+            Avoid_To_World(plan, x, y + l, &wx, &wy);
+            if (Grid_Occupied(wx, wy)) return x;
+        }
     }
+    return -1.0f;
+}
 
-    // 3. 测量 Echo 高电平时间
-    // 注意：这里使用简单的循环计数，会被中断打断，精度一般但够用
-    timeout = 100000; // 防止死循环
-    while(HAL_GPIO_ReadPin(HCSR04_ECHO_PORT, HCSR04_ECHO_PIN) == GPIO_PIN_SET)
+/**
+ * @brief 剩余路径被挡住时就地修正，不停车重新测量:
+ *        挡在越过段终点之前 -> Y 加大一格；挡在切回段 (前方还有障碍物) -> 越过段延长到受阻处之后
+ */
+static void Avoid_Plan_Check(AVOID_PLAN_T *plan, const ODOM_POSE_T *pose)
+{
+    float xb = Avoid_Path_Blocked(plan, pose->x);
+
+    if (xb < 0.0f) return;
+    if (xb <= plan->x2)
+    {
+        if (plan->y_off >= AVOID_MAX_HALF_W_M + AVOID_CAR_HALF_W_M + AVOID_MARGIN_M) return;
+        plan->y_off += GRID_CELL_M;
+    }
+    else
     {
-        local_count++;
-        Delay_us(1); // 延时1us
-        if(timeout-- == 0) break;
+        if (xb + GRID_CELL_M + AVOID_MARGIN_M > plan->x0 + AVOID_MAX_PASS_M) return;
+        plan->x2 = xb + GRID_CELL_M + AVOID_MARGIN_M;
     }
+    plan->x3 = plan->x2 + 1.875f * plan->y_off / AVOID_RETURN_SLOPE;
+    plan->replans++;
+}
+
+/**
+ * @brief 纯追踪: 取前视距离处的路径点，按车体坐标系下的横向偏差求曲率，换算为左右轮速
+ */
+static void Avoid_Pursuit(const AVOID_PLAN_T *plan, const ODOM_POSE_T *pose, int speed, int *left, int *right)
+{
+    float yaw = pose->yaw * AVOID_DEG2RAD;
+    float dx = AVOID_LOOKAHEAD_M;
+    float dy = Avoid_Path_Y(plan, pose->x + dx) - pose->y;
+    float ly = -sinf(yaw) * dx + cosf(yaw) * dy;
+    float kappa = 2.0f * ly / (dx * dx + dy * dy);
 
-    // 4. 计算距离
-    // 公式: 距离 = 时间(us) * 0.034cm/us / 2
-    // 0.017 是理论值。如果发现测距不准（比如实际10cm测出20cm），请修改这个系数
-    return (float)local_count * 0.017f; 
+    if (kappa > AVOID_KAPPA_MAX) kappa = AVOID_KAPPA_MAX;
+    if (kappa < -AVOID_KAPPA_MAX) kappa = -AVOID_KAPPA_MAX;
+    *left = (int)((float)speed * (1.0f - kappa * AVOID_TRACK_M * 0.5f));
+    *right = (int)((float)speed * (1.0f + kappa * AVOID_TRACK_M * 0.5f));
 }
 
 /**
- * @brief 执行避障流程 (阻塞式状态机)
- * 逻辑: 发现障碍 -> 左转90 -> 直行 -> 右转90 -> 直行(过障碍) -> 右转90(切回线) -> 找线 -> 左转回正
+ * @brief 执行避障流程 (阻塞式，在避障任务中运行)
+ * 逻辑: 以触发时的位置和车头方向为原点，里程计 + 陀螺仪航向推算位姿，
+ *       减速直行同时舵机扫描 -> 选择绕行方向 -> (近则倒车) -> 纯追踪沿平滑绕行路径行驶 (切出 -> 越过 -> 切回)
+ *       -> 压线回正后交还循迹；走完路径仍未压线则以触发时的位姿为预期线找线
+ * 路径曲率连续，扫描之后保持巡航速度；切出幅度由测得的障碍物距离和宽度决定
  */
 void Run_Obstacle_Avoidance(void)
-{	
+{
+    AVOID_PLAN_T plan;
+    ODOM_POSE_T lp;
+    const ODOM_POSE_T *w;
+    float ahead;
+    uint32_t t0 = Timebase_Now_Us();
+    uint32_t tick;
+    float min_v = 1.0e3f;
+    int scan_speed = AVOID_SPEED;
+
     // 1. 挂起寻迹任务
     if(MotorConfigHandle != NULL) 
     {
         vTaskSuspend(MotorConfigHandle);
     }
-	
-    // 2. 倒车缓冲
-    Car_Set_Speed(-20, -20);
-    osDelay(200);
-    Car_Set_Speed(0, 0);
-    osDelay(200);
-    
-    // 【切记】不要在这里 Calibrate，除非你确定车绝对静止
-	
-    // 3. 第一阶段：左转绕出
-    MPU6050_Turn_Angle(85.0f, 20); 
-	
-    // 4. 第二阶段：直行 (侧边)
-    Car_Go_Straight_Gyro_Integration(20, 1000,100); // 删掉了多余的参数 100
-
-    // 5. 第三阶段：右转平行
-    MPU6050_Turn_Angle(-85.0f, 20);	
-
-    // 6. 第四阶段：直行 (过障碍)
-    Car_Go_Straight_Gyro_Integration(20, 1200,100);
-
-    // 7. 第五阶段：右转切入
-    MPU6050_Turn_Angle(-85.0f, 20);
-
-    // 8. 第六阶段：找线 (修改了逻辑)
-    // 不要用循环调 Gyro 函数，直接慢速开
-    Car_Set_Speed(20, 20); 
-    
-    // 增加超时保护，防止永远找不到线死在这里
-    uint32_t find_line_timeout = 1000; // 3秒超时
-    uint32_t tick = 0;
-    
-    while(!(READ_L1 || READ_R1))
-    {    
-        osDelay(5);
-        tick += 5;
-        if(tick > find_line_timeout) break; // 超时强制退出
-    }
-    
-    // 压线刹车
-//    Car_Set_Speed(-20, -20);
-//    osDelay(100);
-    Car_Set_Speed(0, 0);
-    osDelay(200); // 等稳一下
-
-    // 9. 第七阶段：左转回正
-    MPU6050_Turn_Angle(85.0f, 20);
-    
-    // 【关键修改】: 回正后，强制往前走一小步，防止立刻再次识别到障碍物
-    // 这一步能有效解决“一直循环避障”的问题
-    Car_Set_Speed(20, 20);
-    osDelay(300); 
-    
-    // 恢复环境
+    Telemetry_Set_State(TLM_STATE_AVOID);
+
+    // 2. 以当前位姿为原点，障碍物前沿取栅格中通道内最近的占据格 (没有时取最近一次测距)
+    Odom_Update(MPU6050_Get_GyroZ_dps());
+    w = Odom_Get();
+    plan.ox = w->x;
+    plan.oy = w->y;
+    plan.oyaw = w->yaw;
+    plan.oc = cosf(w->yaw * AVOID_DEG2RAD);
+    plan.os = sinf(w->yaw * AVOID_DEG2RAD);
+    plan.odist = w->dist;
+    plan.sonar_cnt = 0;
+    plan.replans = 0;
+    Avoid_To_Local(&plan, w, &lp);
+    ahead = Grid_Corridor_Free(w->x, w->y, w->yaw, OBSTACLE_DIST_CM * 0.01f, AVOID_CAR_HALF_W_M);
+    plan.side = AVOID_SIDE;
+    plan.obst_x = (ahead < OBSTACLE_DIST_CM * 0.01f) ? ahead : HCSR04_Get_Last_Distance() * 0.01f;
+    plan.edge_seen = 0;
+    plan.last_range_cm = HCSR04_Get_Last_Distance();
+    plan.last_hit_y = 0.0f;
+    plan.y_off = AVOID_DEFAULT_HALF_W_M + AVOID_CAR_HALF_W_M + AVOID_MARGIN_M;
+#if SCAN_ENABLE
+    plan.leg = AVOID_LEG_SCAN;
+    Scan_Begin();
+#else
+    Avoid_Plan_Start(&plan, &lp);
+#endif
+
+    // 3. 固定周期: 更新位姿 -> (扫描) -> 测距修正路径 -> 纯追踪
+    tick = osKernelGetTickCount();
+    while (plan.leg != AVOID_LEG_DONE)
+    {
+        const ODOM_POSE_T *pose = &lp;
+        int left, right;
+
+        Odom_Update(MPU6050_Get_GyroZ_dps());
+        Avoid_To_Local(&plan, Odom_Get(), &lp);
+
+        if (plan.leg == AVOID_LEG_SCAN)
+        {
+            // 扫描期间不停车，保持航向减速前进，扫描结束时从当前位置生成路径
+            if (scan_speed > AVOID_SCAN_SPEED) scan_speed -= AVOID_DECEL_STEP;
+            Avoid_Hold_Heading(pose, scan_speed, &left, &right);
+            if (Scan_Step(pose))
+            {
+                Avoid_Plan_Scan(&plan);
+                Avoid_Plan_Start(&plan, pose);
+            }
+        }
+        else if (plan.leg == AVOID_LEG_BACK)
+        {
+            // 转向时车头会擦到障碍物，先保持航向直线倒车拉开距离，然后从倒车终点生成路径
+            Avoid_Hold_Heading(pose, -AVOID_SPEED_SLOW, &left, &right);
+            if (plan.obst_x - pose->x >= AVOID_MIN_CLEAR_M) Avoid_Plan_Path(&plan, pose);
+        }
+        else if (plan.leg == AVOID_LEG_PATH)
+        {
+            Avoid_Plan_Measure(&plan, pose);
+            Avoid_Plan_Check(&plan, pose);
+            // 走完路径，或切回后半段压线且航向已回正，交还循迹
+            if (pose->x >= plan.x3 ||
+                (pose->x >= 0.5f * (plan.x2 + plan.x3) && fabsf(pose->yaw) <= AVOID_ALIGN_DEG &&
+                 (READ_L1 || READ_R1 || READ_L2 || READ_R2)))
+            {
+#if RECOVER_ENABLE
+                // 走完路径仍未压线 (里程计漂移 / 线本身有弯): 线应在触发时的位姿上，先摆向绕行的反侧
+                if (!(READ_L1 || READ_R1 || READ_L2 || READ_R2))
+                {
+                    Recover_Set_Line(plan.ox, plan.oy, plan.oyaw);
+                    Recover_Start(RECOVER_SRC_AVOID, (int8_t)-plan.side, Odom_Get());
+                    plan.leg = AVOID_LEG_RECOVER;
+                    continue;
+                }
+#endif
+                plan.leg = AVOID_LEG_DONE;
+                break;
+            }
+            Avoid_Pursuit(&plan, pose, AVOID_SPEED, &left, &right);
+            if (pose->x > plan.x0 + AVOID_LOOKAHEAD_M && pose->v < min_v) min_v = pose->v;
+        }
+#if RECOVER_ENABLE
+        else if (plan.leg == AVOID_LEG_RECOVER)
+        {
+            // 找线用里程计坐标系的位姿，超时由 RECOVER.c 自己判断
+            RECOVER_RESULT_E r = Recover_Step(Odom_Get(), (READ_L1 || READ_R1 || READ_L2 || READ_R2), &left, &right);
+            if (r == RECOVER_FOUND)
+            {
+                plan.leg = AVOID_LEG_DONE;
+                break;
+            }
+            if (r == RECOVER_FAILED) break;
+        }
+#endif
+        Car_Set_Speed(left, right);
+
+        if (plan.leg != AVOID_LEG_RECOVER && Timebase_Elapsed_Us(t0) > AVOID_TIMEOUT_MS * 1000u) break;
+        tick += AVOID_STEP_MS;
+        if (osDelayUntil(tick) != osOK) tick = osKernelGetTickCount();
+    }
+
+    // 4. 记录本次绕行，由服务任务发出
+    avoid_report.duration_ms = Timebase_Elapsed_Us(t0) / 1000u;
+    avoid_report.dist_cm = (uint16_t)(plan.obst_x * 100.0f);
+    avoid_report.half_w_cm = (uint16_t)(plan.edge_seen ? plan.last_hit_y * 100.0f : 0.0f);
+    avoid_report.path_cm = (uint16_t)(fabsf(Odom_Get()->dist - plan.odist) * 100.0f);
+    avoid_report.min_v_cms = (uint16_t)((min_v < 1.0e3f && min_v > 0.0f) ? min_v * 100.0f : 0.0f);
+    avoid_report.leg = plan.leg;
+    avoid_report.side = (int8_t)plan.side;
+    avoid_report.replans = plan.replans;
+    avoid_report.count++;
+    avoid_report_pending = 1;
+
+    // 超时或找线失败则停车等待循迹接手；正常结束时保持速度直接交还，不刹停
+    if (plan.leg != AVOID_LEG_DONE) Car_Set_Speed(0, 0);
     Line_Tracker_Init(); 
-    
-    // 10. 恢复任务
+
+    // 5. 恢复任务
+    Telemetry_Set_State(TLM_STATE_TRACK);
     if(MotorConfigHandle != NULL) 
     {
         vTaskResume(MotorConfigHandle);
     }
-}
\ No newline at end of file
+}
+
+/**
+ * @brief 发送最近一次绕行的结果 (文本行，以 "AVOID" 开头)，由服务任务周期调用
+ */
+void Avoid_Report(void)
+{
+    static char line[128];
+    int len;
+
+    if (!avoid_report_pending) return;
+    if (huart2.gState != HAL_UART_STATE_READY) return;
+
+    len = snprintf(line, sizeof(line), "AVOID n=%lu dur=%lums side=%c blocked=%u replan=%u dist=%ucm half_w=%ucm path=%ucm vmin=%ucm/s %s\r\n",
+                   (unsigned long)avoid_report.count, (unsigned long)avoid_report.duration_ms,
+                   (avoid_report.side > 0) ? 'L' : 'R', avoid_report.blocked, avoid_report.replans,
+                   avoid_report.dist_cm, avoid_report.half_w_cm, avoid_report.path_cm, avoid_report.min_v_cms,
+                   (avoid_report.leg == AVOID_LEG_DONE) ? "ok" :
+                   ((avoid_report.leg == AVOID_LEG_RECOVER) ? "lost" : "timeout"));
+    if (len <= 0) return;
+    if (USART_USER_DMA_USART2TX_TRANSMIT((uint8_t *)line, (uint16_t)len) == HAL_OK)
+    {
+        avoid_report_pending = 0;
+    }
+}
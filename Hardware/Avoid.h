@@ -4,6 +4,7 @@
 #include "MPU6050.h"
 #include "MOTOR.h"
 #include "LINE_TRACKER.h"
+#include "SCAN.h"
 #include "cmsis_os.h"
 
 extern osThreadId_t MotorConfigHandle; 
@@ -18,12 +19,22 @@ extern osThreadId_t MotorConfigHandle;
 #define HCSR04_ECHO_PIN     GPIO_PIN_1
 
 /* ================= 2. ãÐÖµ¶¨Òå ================= */
-#define OBSTACLE_DIST_CM    20.0f
-#define OBSTACLE_AVOIDANCE_FLAG 0x0001U
+#if SCAN_ENABLE
+#define OBSTACLE_DIST_CM    50.0f   // 扫描期间 (约 0.6s) 减速前进，在切出所需距离上再留出这段
+#else
+#define OBSTACLE_DIST_CM    35.0f   // 平滑绕行需要纵向距离完成切出，触发距离不宜小于 AVOID_MIN_CLEAR_M
+#endif
 
 /* ================= 3. º¯ÊýÉùÃ÷ ================= */
 void Obstacle_Init(void);           // ³õÊ¼»¯ (Èç¹ûCubeMXÃ»ÅäGPIO£¬ÐèÔÚ´ËÅäÖÃ)
+float HCSR04_Get_Last_Distance(void);   // 最近一次测距结果
+uint32_t HCSR04_Get_Last_Time_Us(void); // 最近一次测距的时间戳 (us)
 float HCSR04_Read_Distance(void);   // ¶ÁÈ¡¾àÀë
+void HCSR04_Trigger(void);          // 发起一次测距，不等待回波
+uint8_t HCSR04_Poll(float *cm);     // 取 Trigger 的结果: 1 已完成，0 回波未结束
+void HCSR04_Echo_Edge(void);        // Echo 边沿中断中调用
+uint8_t Obstacle_Detect(void);      // 测距写入占据栅格并检查前方通道
 void Run_Obstacle_Avoidance(void);  // Ö´ÐÐ±ÜÕÏÈ«Á÷³Ì
+void Avoid_Report(void);            // 发送最近一次绕行的结果 (服务任务调用)
 
 #endif
\ No newline at end of file
@@ -0,0 +1,150 @@
+#include "GRID.h"
+#include "TIMEBASE.h"
+#include "main.h"
+#include "math.h"
+#include "string.h"
+
+#define GRID_MASK       (GRID_N - 1)
+#define GRID_DEG2RAD    0.017453293f
+
+static uint8_t grid_cells[GRID_N][GRID_N / 2];  // [行 y][列 x / 2]，低 4 位为偶数列
+static int32_t grid_org_x = 0;                  // 窗口左下角的格子坐标
+static int32_t grid_org_y = 0;
+static uint8_t grid_valid = 0;                  // 窗口已随小车定位
+
+static int32_t Grid_Cell(float v)
+{
+    return (int32_t)floorf(v / GRID_CELL_M);
+}
+
+static int8_t Grid_Cell_Get(int32_t cx, int32_t cy)
+{
+    uint8_t b = grid_cells[cy & GRID_MASK][(cx & GRID_MASK) >> 1];
+    uint8_t v = (cx & 1) ? (b >> 4) : (b & 0x0F);
+    return (int8_t)((int8_t)(v ^ 0x08) - 8);    // 4 位符号扩展
+}
+
+static void Grid_Cell_Add(int32_t cx, int32_t cy, int8_t d)
+{
+    uint8_t *b;
+    int8_t v;
+
+    // 窗口外不记录
+    if ((uint32_t)(cx - grid_org_x) >= GRID_N || (uint32_t)(cy - grid_org_y) >= GRID_N) return;
+
+    v = Grid_Cell_Get(cx, cy) + d;
+    if (v > GRID_L_MAX) v = GRID_L_MAX;
+    if (v < GRID_L_MIN) v = GRID_L_MIN;
+    b = &grid_cells[cy & GRID_MASK][(cx & GRID_MASK) >> 1];
+    if (cx & 1) *b = (uint8_t)((*b & 0x0F) | ((uint8_t)v << 4));
+    else *b = (uint8_t)((*b & 0xF0) | ((uint8_t)v & 0x0F));
+}
+
+/**
+ * @brief 窗口以 (cx, cy) 为中心，移出窗口的列 / 行清零 (与新移入的共用存储)
+ */
+static void Grid_Recenter(int32_t cx, int32_t cy)
+{
+    int32_t ox = cx - GRID_N / 2;
+    int32_t oy = cy - GRID_N / 2;
+    int32_t c, r;
+
+    if (!grid_valid || ox - grid_org_x >= GRID_N || grid_org_x - ox >= GRID_N ||
+        oy - grid_org_y >= GRID_N || grid_org_y - oy >= GRID_N)
+    {
+        memset(grid_cells, 0, sizeof(grid_cells));
+        grid_org_x = ox;
+        grid_org_y = oy;
+        grid_valid = 1;
+        return;
+    }
+
+    // 1. 列: [min, max) 范围内的列号既是移出的也是移入的
+    for (c = (ox > grid_org_x) ? grid_org_x : ox; c < ((ox > grid_org_x) ? ox : grid_org_x); c++)
+    {
+        uint8_t keep = (c & 1) ? 0x0F : 0xF0;
+        for (r = 0; r < GRID_N; r++) grid_cells[r][(c & GRID_MASK) >> 1] &= keep;
+    }
+    // 2. 行整行清零
+    for (r = (oy > grid_org_y) ? grid_org_y : oy; r < ((oy > grid_org_y) ? oy : grid_org_y); r++)
+    {
+        memset(grid_cells[r & GRID_MASK], 0, GRID_N / 2);
+    }
+    grid_org_x = ox;
+    grid_org_y = oy;
+}
+
+void Grid_Clear(void)
+{
+    grid_valid = 0;
+}
+
+void Grid_Insert(const ODOM_POSE_T *pose, float angle_deg, float range_cm, uint32_t time_us)
+{
+    uint32_t age = pose->time_us - time_us;
+    float back, a, r, x, y;
+    int32_t x0, y0, x1, y1, dx, dy, sx, sy, err, e2;
+    uint8_t hit;
+
+    // 1. 测距时刻的位姿: 按车速沿航向回推 (测距早于位姿更新时)
+    if ((int32_t)age < 0) age = 0;
+    if (age > GRID_MAX_AGE_US) return;
+    back = pose->v * (float)age / (float)TIMEBASE_HZ;
+    a = pose->yaw * GRID_DEG2RAD;
+    x = pose->x - back * cosf(a);
+    y = pose->y - back * sinf(a);
+
+    x0 = Grid_Cell(x);
+    y0 = Grid_Cell(y);
+    Grid_Recenter(x0, y0);
+
+    // 2. 波束终点，超出可信距离的只记空闲段
+    r = range_cm * 0.01f;
+    hit = (range_cm < 999.0f && r <= GRID_MAX_RANGE_M);
+    if (!hit) r = GRID_MAX_RANGE_M;
+    a += angle_deg * GRID_DEG2RAD;
+    x1 = Grid_Cell(x + r * cosf(a));
+    y1 = Grid_Cell(y + r * sinf(a));
+
+    // 3. Bresenham 逐格: 途经格空闲，终点格占据
+    dx = (x1 > x0) ? (x1 - x0) : (x0 - x1);
+    dy = (y1 > y0) ? (y0 - y1) : (y1 - y0);
+    sx = (x0 < x1) ? 1 : -1;
+    sy = (y0 < y1) ? 1 : -1;
+    err = dx + dy;
+    while (x0 != x1 || y0 != y1)
+    {
+        Grid_Cell_Add(x0, y0, -GRID_L_FREE);
+        e2 = 2 * err;
+        if (e2 >= dy) { err += dy; x0 += sx; }
+        if (e2 <= dx) { err += dx; y0 += sy; }
+    }
+    Grid_Cell_Add(x1, y1, hit ? GRID_L_OCC : -GRID_L_FREE);
+}
+
+uint8_t Grid_Occupied(float x, float y)
+{
+    int32_t cx = Grid_Cell(x);
+    int32_t cy = Grid_Cell(y);
+
+    if (!grid_valid) return 0;
+    if ((uint32_t)(cx - grid_org_x) >= GRID_N || (uint32_t)(cy - grid_org_y) >= GRID_N) return 0;
+    return (Grid_Cell_Get(cx, cy) >= GRID_OCC_TH);
+}
+
+float Grid_Corridor_Free(float x, float y, float yaw_deg, float length, float half_w)
+{
+    float c = cosf(yaw_deg * GRID_DEG2RAD);
+    float s = sinf(yaw_deg * GRID_DEG2RAD);
+    float d, l;
+
+    // 按半格取样，通道斜着穿过格子时也不会漏过
+    for (d = 0.0f; d <= length; d += 0.5f * GRID_CELL_M)
+    {
+        for (l = -half_w; l <= half_w + 0.001f; l += 0.5f * GRID_CELL_M)
+        {
+            if (Grid_Occupied(x + d * c - l * s, y + d * s + l * c)) return d;
+        }
+    }
+    return length;
+}
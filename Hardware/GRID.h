@@ -0,0 +1,48 @@
+#ifndef __GRID_H
+#define __GRID_H
+
+#include "stdint.h"
+#include "ODOMETRY.h"
+
+/*
+ * 局部占据栅格
+ * 以小车为中心的滚动窗口，轴向与里程计坐标系一致，车移动超过一格时窗口随之平移，移出的行列清零 (未知)
+ * 每格 4 位有符号 log-odds (两格一字节，按行存放)，64 x 64 格 x 5cm = 3.2m 见方，共 2KB
+ * 超声波测距按测量时刻的位姿沿波束方向投射: 途经的格子 -GRID_L_FREE，回波所在格 +GRID_L_OCC
+ * 波束按一条射线处理 (HC-SR04 实际约 15° 张角)，宽障碍物由舵机扫描的多条射线覆盖
+ */
+
+#define GRID_CELL_M         0.05f       // 格子边长
+#define GRID_BITS           6           // 边长 64 格
+#define GRID_N              (1 << GRID_BITS)
+#define GRID_L_OCC          3           // 命中一次即判为占据
+#define GRID_L_FREE         1           // 穿过两次即恢复为空闲 (滤掉偶发的假回波)
+#define GRID_L_MIN          (-8)        // 4 位有符号范围
+#define GRID_L_MAX          7
+#define GRID_OCC_TH         2           // log-odds 不小于该值为占据
+#define GRID_MAX_RANGE_M    1.5f        // 更远的回波不可信，只把这段射线记为空闲
+#define GRID_MAX_AGE_US     100000u     // 超过该年龄的测距不再写入
+
+/**
+ * @brief 清空栅格 (全部未知)
+ */
+void Grid_Clear(void);
+/**
+ * @brief 写入一次测距
+ * @param pose 里程计位姿 (按测距时刻与 pose->time_us 之差沿航向回推)
+ * @param angle_deg 波束相对车头的角度 (左为正)
+ * @param range_cm 测距结果，999 为无回波
+ * @param time_us 测距时刻 (HCSR04_Get_Last_Time_Us)
+ */
+void Grid_Insert(const ODOM_POSE_T *pose, float angle_deg, float range_cm, uint32_t time_us);
+/**
+ * @brief 该点所在格子是否占据 (窗口外视为未知，不占据)
+ */
+uint8_t Grid_Occupied(float x, float y);
+/**
+ * @brief 沿 yaw 方向宽 2 * half_w 的通道内，从 (x, y) 起到第一个占据格的距离
+ * @return 距离 (m)，通道内无占据格时返回 length
+ */
+float Grid_Corridor_Free(float x, float y, float yaw_deg, float length, float half_w);
+
+#endif // __GRID_H
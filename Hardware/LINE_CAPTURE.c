@@ -0,0 +1,112 @@
+#include "LINE_CAPTURE.h"
+#include "main.h"
+#include "string.h"
+
+extern TIM_HandleTypeDef htim8;
+extern DMA_HandleTypeDef hdma_tim8_up;
+
+/*
+ * 采样字节 = GPIOD->IDR bit15..8，低 4 位: PD8 L1, PD9 L2, PD10 R1, PD11 R2，低电平为压线
+ * 查表转换为 Get_Line_Error 的组合 (压线为 1): L2 L1 R1 R2 -> bit3..bit0
+ */
+static const uint8_t line_cap_state_lut[16] = {
+    0x0F, 0x0B, 0x07, 0x03, 0x0D, 0x09, 0x05, 0x01,
+    0x0E, 0x0A, 0x06, 0x02, 0x0C, 0x08, 0x04, 0x00,
+};
+
+static uint8_t line_cap_buf[LINE_CAP_BUF_SIZE];
+static uint32_t line_cap_tail = 0;      // 下一个待处理的采样
+static uint32_t line_cap_last_us = 0;   // 上次归约的时刻
+static uint8_t line_cap_prev = 0;       // 上一个采样的组合，跨窗口检测跳变
+static uint8_t line_cap_running = 0;
+
+void Line_Capture_Init(void)
+{
+#if LINE_CAP_ENABLE
+    // 外设地址取 IDR 的第 2 个字节 (小端: bit15..8)，字节访问 GPIO 寄存器是允许的
+    HAL_DMA_Start(&hdma_tim8_up, (uint32_t)&GPIOD->IDR + 1, (uint32_t)line_cap_buf, LINE_CAP_BUF_SIZE);
+    __HAL_TIM_ENABLE_DMA(&htim8, TIM_DMA_UPDATE);
+    HAL_TIM_Base_Start(&htim8);
+
+    line_cap_tail = 0;
+    line_cap_last_us = Timebase_Now_Us();
+    line_cap_prev = line_cap_state_lut[(GPIOD->IDR >> 8) & 0x0F];
+    line_cap_running = 1;
+#endif
+}
+
+void Line_Capture_Flush(void)
+{
+    if (!line_cap_running) return;
+    line_cap_tail = (LINE_CAP_BUF_SIZE - __HAL_DMA_GET_COUNTER(&hdma_tim8_up)) & (LINE_CAP_BUF_SIZE - 1);
+    line_cap_last_us = Timebase_Now_Us();
+    line_cap_prev = line_cap_state_lut[(GPIOD->IDR >> 8) & 0x0F];
+}
+
+uint16_t Line_Capture_Reduce(LINE_CAP_T *cap)
+{
+    uint32_t head, n, t, i, k;
+    uint8_t prev = line_cap_prev;
+
+    if (!line_cap_running) return 0;
+
+    PROF_BEGIN(PROF_LINE_CAPTURE);
+
+    // 1. DMA 写位置 (NDTR 为剩余个数) 和当前时刻，head - 1 即最新的采样
+    head = (LINE_CAP_BUF_SIZE - __HAL_DMA_GET_COUNTER(&hdma_tim8_up)) & (LINE_CAP_BUF_SIZE - 1);
+    t = Timebase_Now_Us();
+    n = (head - line_cap_tail) & (LINE_CAP_BUF_SIZE - 1);
+    cap->overrun = 0;
+    // 间隔超过一个缓冲，位置差已经回绕，只处理最近的 (正在写的那个除外)
+    if (t - line_cap_last_us >= (LINE_CAP_BUF_SIZE - 1) * LINE_CAP_SAMPLE_US)
+    {
+        n = LINE_CAP_BUF_SIZE - 1;
+        cap->overrun = 1;
+    }
+    line_cap_last_us = t;
+
+    memset(cap->state_count, 0, sizeof(cap->state_count));
+    memset(cap->edges, 0, sizeof(cap->edges));
+    cap->samples = (uint16_t)n;
+    cap->end_us = t;
+
+    // 2. 逐个采样统计组合，并记录跳变 (第 i 个采样的时刻 = t - (n - 1 - i) 个采样周期)
+    i = (head - n) & (LINE_CAP_BUF_SIZE - 1);
+    for (k = 0; k < n; k++)
+    {
+        uint8_t st = line_cap_state_lut[line_cap_buf[i] & 0x0F];
+        uint8_t diff = st ^ prev;
+        cap->state_count[st]++;
+        if (diff)
+        {
+            uint32_t t_edge = t - (n - 1 - k) * LINE_CAP_SAMPLE_US;
+            for (uint8_t s = 0; s < LINE_CAP_NUM; s++)
+            {
+                if (diff & (1u << s))
+                {
+                    cap->edges[s]++;
+                    cap->edge_us[s] = t_edge;
+                }
+            }
+        }
+        prev = st;
+        i = (i + 1) & (LINE_CAP_BUF_SIZE - 1);
+    }
+    line_cap_tail = head;
+    line_cap_prev = prev;
+    cap->state = prev;
+
+    // 3. 各路占空比由组合次数汇总，不在逐采样循环里做
+    for (uint8_t s = 0; s < LINE_CAP_NUM; s++)
+    {
+        uint16_t sum = 0;
+        for (k = 0; k < 16; k++)
+        {
+            if (k & (1u << s)) sum += cap->state_count[k];
+        }
+        cap->active[s] = sum;
+    }
+
+    PROF_END(PROF_LINE_CAPTURE);
+    return (uint16_t)n;
+}
@@ -0,0 +1,62 @@
+#ifndef __LINE_CAPTURE_H
+#define __LINE_CAPTURE_H
+
+#include "stdint.h"
+
+/*
+ * 循迹传感器过采样
+ * TIM8 更新事件 (20kHz) 触发 DMA2_Stream1，把 GPIOD->IDR 的高字节 (PD8..PD15) 搬进环形缓冲，不占用 CPU
+ * GPIO 挂在 AHB1 上，只有 DMA2 能访问，所以触发源用 APB2 的 TIM8 (TIM8_UP: DMA2 Stream1 Channel 7)
+ *
+ * 循迹任务每个控制周期调用 Line_Capture_Reduce()，把上次调用以来的全部采样归约为:
+ *   各传感器组合出现的次数 -> 误差按次数加权平均，传感器压在线边缘时得到连续值
+ *   各路压线的采样数 (占空比) 和最近一次跳变的时刻
+ * 10ms 控制周期约 200 个采样 (归约耗时见 PROF_LINE_CAPTURE)；两次调用间隔超过缓冲长度 (25.6ms) 时只处理最近一缓冲的数据
+ */
+
+#ifndef LINE_CAP_ENABLE
+#define LINE_CAP_ENABLE         1
+#endif
+#define LINE_CAP_RATE_HZ        20000u  // 与 MX_TIM8_Init 一致: 168MHz / 8400
+#define LINE_CAP_SAMPLE_US      (1000000u / LINE_CAP_RATE_HZ)
+#define LINE_CAP_BUF_SIZE       512     // 采样个数，必须为 2 的幂 (1 字节 / 采样)
+
+/* 传感器序号，与 Get_Line_Error 的组合位 L2 L1 R1 R2 -> bit3..bit0 对应 */
+typedef enum
+{
+    LINE_CAP_R2 = 0,        // bit0
+    LINE_CAP_R1,            // bit1
+    LINE_CAP_L1,            // bit2
+    LINE_CAP_L2,            // bit3
+    LINE_CAP_NUM
+} LINE_CAP_SENSOR_E;
+
+/* 一个控制周期的归约结果 */
+typedef struct
+{
+    uint16_t samples;                   // 本窗口采样数
+    uint16_t state_count[16];           // 各组合 (压线为 1) 出现的次数
+    uint16_t active[LINE_CAP_NUM];      // 各路压线的采样数，占空比 = active / samples
+    uint8_t  edges[LINE_CAP_NUM];       // 各路跳变次数
+    uint8_t  state;                     // 窗口内最后一个采样的组合
+    uint8_t  overrun;                   // 1: 距上次归约超过缓冲长度，较早的采样已被覆盖
+    uint32_t edge_us[LINE_CAP_NUM];     // 各路最近一次跳变的时刻 (TIMEBASE 微秒)，本窗口无跳变时保持上一次的值
+    uint32_t end_us;                    // 窗口最后一个采样的时刻 (误差不超过 1 个采样周期)
+} LINE_CAP_T;
+
+/**
+ * @brief 启动 TIM8 + DMA 采样，在 MX_TIM8_Init 之后调用
+ */
+void Line_Capture_Init(void);
+/**
+ * @brief 丢弃尚未归约的采样 (如盲转、避障结束后重新开始循迹时)，下一窗口从现在开始
+ */
+void Line_Capture_Flush(void);
+/**
+ * @brief 归约上次调用以来的全部采样，只应由循迹任务调用
+ * @param cap 输出，edge_us 需在两次调用之间保留 (用静态变量)
+ * @return 本窗口采样数，0 表示没有新采样 (采样未启动)，此时 cap 除 edge_us 外无效
+ */
+uint16_t Line_Capture_Reduce(LINE_CAP_T *cap);
+
+#endif // __LINE_CAPTURE_H
@@ -1,4 +1,16 @@
 #include "line_tracker.h"
+#include "STEER_CTRL.h"
+#include "MPU6050.h"
+#include "Avoid.h"
+#include "TELEMETRY.h"
+#include "PROFILE.h"
+#include "TRACE.h"
+#include "TIMEBASE.h"
+#include "LINE_CAPTURE.h"
+#include "ODOMETRY.h"
+#include "RECOVER.h"
+#include "MOTION.h"
+#include "VISION.h"
 #include "math.h"   
 #include "stdlib.h" 
 
@@ -13,7 +25,32 @@
 
 /* 2. ·ת () */
 #define TURN_SPEED          25   // ·תʱٶ
-#define TURN_DURATION_MS    400  // äתʱ(ms)ݳٵȷתʮ·
+#define TURN_ANGLE_DEG      90.0f // תĿ꺽仯 (ںϺ / Ħ޹)
+#define TURN_EXIT_MIN_DEG   45.0f // תýǶȺ L1 / R1 ѹ֧·ǰ
+#define TURN_TIMEOUT_MS     1500 // תʱ (ԭäת̶ 400ms)
+#define STRAIGHT_DIST_M     0.10f // ֱд·ڵľ
+#define STRAIGHT_EXIT_MIN_M 0.04f // ֱйþ L1 / R1 ѹ߼ǰ
+#define JUNCTION_BACK_SPEED 20   // ⵽·ں󵹳ɲͣٶ
+#define JUNCTION_BACK_MS    100  // ɲͣʱ
+
+/* 3. ת */
+#define LINE_STEER_SCHEDULED 1      // 1:  PID + ΢˲ + ٶǰ; 0: ԭ̶ PD
+#define LINE_STEER_USE_GYRO 1       // 1: MPU6050 ٶΪǰ (ÿĶΪȡ 0 ʡ I2C ʱ)
+#define STEER_D_CUTOFF_HZ   15.0f   // ΢ֹͨƵ
+#define STEER_FF_CUTOFF_HZ  2.0f    // ٶǰֹͨƵ
+#define STEER_I_LIMIT       8.0f    // ޷
+#define STEER_I_ZONE        3.0f    // || СڴֵŻ
+#define STEER_OUT_LIMIT     100.0f
+
+/* 4.  */
+#define LINE_USE_CAPTURE    1       // 1: ȡһ 20kHz ļȨƽ (LINE_CAPTURE.c); 0: ÿĶһ
+
+/* 5.  (RECOVER.c) */
+#define LANE_PREVIEW_ENABLE 1       // 1: K230 ǰӳΪתǰ (VISION.c); 0: ֻóµĴ
+#define LANE_MAX_AGE_MS     100u    // ʱЧ (Լ 3 ֡) ĳݲãǰΪ 0
+#define LANE_OFFSET_W       2.0f    // ǰƫ ( = 1) -> λ
+#define LANE_CURV_W         4.0f    //  ( = 1) -> λ
+#define LINE_LOST_MS        150     // ĸȫ׳ʱתߣ̵Ķ԰ 4 ش
 
 /* ============================================ */
 
@@ -32,21 +69,57 @@ extern osThreadId_t MVHandle;
 // ߶о (ڽָ: 1=, 2=, 3=ֱ)
 extern osMessageQueueId_t MotorQueueHandle; 
 
-/* PID ݽṹ (ֲ) */
-typedef struct {
-    float error;       
-    float last_error;  
-    float output;      
-} PID_TypeDef;
+/* ԭ̶ PD (STEER_MODE_PD ʱʹ) */
+static const STEER_GAIN_T line_pd_gain[] = {
+    { 0, PID_KP, 0, PID_KD, 0, 0 },
+};
+
+/* ȱ̬ٶԲֵ Tools/line_sim  */
+static const STEER_GAIN_T line_gain_schedule[] = {
+    /* speed   kp     ki     kd     kff    kpv (ǰӣline_sim κϳǰ֤ڳ) */
+    {  20.0f,  5.0f,  2.0f,  0.10f, 0.02f, 1.0f },
+    {  40.0f,  8.0f,  3.0f,  0.20f, 0.03f, 2.0f },
+    {  60.0f, 11.0f,  4.0f,  0.30f, 0.05f, 3.0f },
+};
 
-static PID_TypeDef line_pid;
+static const STEER_CFG_T line_steer_cfg = {
+#if LINE_STEER_SCHEDULED
+    .mode         = STEER_MODE_SCHEDULED,
+    .schedule     = line_gain_schedule,
+    .schedule_len = sizeof(line_gain_schedule) / sizeof(line_gain_schedule[0]),
+#else
+    .mode         = STEER_MODE_PD,
+    .schedule     = line_pd_gain,
+    .schedule_len = 1,
+#endif
+    .d_cutoff_hz  = STEER_D_CUTOFF_HZ,
+    .ff_cutoff_hz = STEER_FF_CUTOFF_HZ,
+    .i_limit      = STEER_I_LIMIT,
+    .i_zone       = STEER_I_ZONE,
+    .out_limit    = STEER_OUT_LIMIT,
+};
 
-/* ʼ (ֲ) */
+static STEER_CTRL_T line_steer = { .cfg = &line_steer_cfg };
+static uint32_t line_last_us = 0;       // һĴʱ (TIMEBASE ΢)
+static uint32_t line_sample_us = 0;     // Ĵʱ
+static uint8_t line_sensor_state = 0;   // һδ״̬ң¼
+static uint8_t line_seen = 0;           // дѹ
+static float last_valid_error = 0;      // һѹʱ (: Ҳ)
+static uint32_t line_seen_us = 0;       // һѹߵĲʱ
+static uint8_t line_recover = 0;        // 0: ѭ 1:  2: ʧܣͣ
+static uint8_t line_junction = 0;       // 0: ѭ 1: ·ڵɲͣ 2: ͣȣȴӾָ
+static uint8_t line_turn_cmd = 0;       // ִе·ָ
+static float line_turn_yaw0 = 0.0f;     // ·ڶʼʱĺ / ·
+static float line_turn_dist0 = 0.0f;
+
+/* ʼʷ */
 void Line_Tracker_Init(void)
 {
-    line_pid.error = 0;
-    line_pid.last_error = 0;
-    line_pid.output = 0;
+    Steer_Ctrl_Init(&line_steer, &line_steer_cfg);
+    line_last_us = Timebase_Now_Us();
+    line_seen_us = line_last_us;
+    line_recover = 0;
+    Line_Capture_Flush();
 }
 
 /*  (ֲ) */
@@ -58,17 +131,9 @@ static int Apply_Dead_Zone(int speed)
     return speed;
 }
 
-/* ȡ (ֲ) */
-static float Get_Line_Error(void)
+/*  ->  (ֲ) */
+static float Line_State_Error(uint8_t sensor_state, float last_valid_error)
 {
-    uint8_t sensor_state = 0;
-    static float last_valid_error = 0; 
-
-    if(READ_L2) sensor_state |= 0x08; 
-    if(READ_L1) sensor_state |= 0x04; 
-    if(READ_R1) sensor_state |= 0x02; 
-    if(READ_R2) sensor_state |= 0x01; 
-
     float current_error = 0;
 
     switch (sensor_state)
@@ -91,42 +156,220 @@ static float Get_Line_Error(void)
             break;
         default: current_error = last_valid_error; break;
     }
+    return current_error;
+}
+
+/* ȡ */
+static float Get_Line_Error(void)
+{
+    uint8_t sensor_state = 0;
+    float current_error;
+
+#if LINE_USE_CAPTURE
+    static LINE_CAP_T cap;
+    if (Line_Capture_Reduce(&cap) != 0)
+    {
+        // ϵִȨƽ: ߱Եʱɢֵ֮
+        float sum = 0.0f;
+        for (uint8_t s = 0; s < 16; s++)
+        {
+            if (cap.state_count[s] != 0) sum += (float)cap.state_count[s] * Line_State_Error(s, last_valid_error);
+        }
+        current_error = sum / (float)cap.samples;
+        line_sample_us = cap.end_us;
+        line_sensor_state = cap.state;
+        line_seen = (cap.state_count[0] != cap.samples);
+        if (line_seen) last_valid_error = current_error;
+        return current_error;
+    }
+#endif
+
+    line_sample_us = Timebase_Now_Us();
+    if(READ_L2) sensor_state |= 0x08; 
+    if(READ_L1) sensor_state |= 0x04; 
+    if(READ_R1) sensor_state |= 0x02; 
+    if(READ_R2) sensor_state |= 0x01; 
+    line_sensor_state = sensor_state;
 
-    if (sensor_state != 0x00) last_valid_error = current_error;
+    current_error = Line_State_Error(sensor_state, last_valid_error);
+    line_seen = (sensor_state != 0x00);
+    if (line_seen) last_valid_error = current_error;
     return current_error;
 }
 
-/* [] ִ·äת
+static int16_t Line_Tlm_Scale(float x, float scale)
+{
+    x *= scale;
+    if (x > 32767.0f) return 32767;
+    if (x < -32768.0f) return -32768;
+    return (int16_t)x;
+}
+
+/* дһң¼ (ֱдλеĲλ) */
+static void Line_Log_Tick(float error, float yaw_rate, int left, int right, uint32_t latency_us)
+{
+    TLM_RECORD_T *rec = Telemetry_Begin();
+    float dist = HCSR04_Get_Last_Distance();
+
+    rec->error    = Line_Tlm_Scale(error, 100.0f);
+    rec->output   = Line_Tlm_Scale(line_steer.output, 10.0f);
+    rec->left     = (int8_t)(left > 127 ? 127 : (left < -127 ? -127 : left));
+    rec->right    = (int8_t)(right > 127 ? 127 : (right < -127 ? -127 : right));
+    rec->sensor   = line_sensor_state;
+    rec->yaw_rate = Line_Tlm_Scale(yaw_rate, 10.0f);
+    rec->distance = (dist >= 999.0f) ? 0xFFFF : (uint16_t)(dist * 10.0f);
+    rec->p_term   = Line_Tlm_Scale(line_steer.p_term, 10.0f);
+    rec->i_term   = Line_Tlm_Scale(line_steer.integral, 10.0f);
+    rec->d_term   = Line_Tlm_Scale(line_steer.d_term, 10.0f);
+    rec->ff_term  = Line_Tlm_Scale(line_steer.ff_term, 10.0f);
+    rec->latency_us = (uint16_t)(latency_us > 0xFFFF ? 0xFFFF : latency_us);
+    rec->pv_term  = (int8_t)(line_steer.pv_term > 127.0f ? 127 : (line_steer.pv_term < -127.0f ? -127 : (int)line_steer.pv_term));
+    Telemetry_Commit(rec);
+}
+
+#if LANE_PREVIEW_ENABLE
+/**
+ * @brief ͷǰ (λ: ǰҲ)û㹻µĳʱΪ 0
+ */
+static float Line_Lane_Preview(void)
+{
+    VISION_LANE_T lane;
+
+    if (!Vision_Get_Lane(LANE_MAX_AGE_MS, &lane)) return 0.0f;
+    return LANE_OFFSET_W * (float)lane.offset / 100.0f + LANE_CURV_W * (float)lane.curv / 100.0f;
+}
+#endif
+
+#if RECOVER_ENABLE
+/**
+ * @brief ߼ʱ
+ * @return 1: ĵ߽ӹܣѭ
+ */
+static uint8_t Line_Recover_Tick(float error, float yaw_rate)
+{
+    const ODOM_POSE_T *pose = Odom_Get();
+    int left, right;
+
+    // 1. : ¼Ԥߣݶѭϴش
+    if (line_recover == 0)
+    {
+        if (line_seen)
+        {
+            line_seen_us = line_sample_us;
+            Recover_Note_Line(pose, error);
+            return 0;
+        }
+        if (line_sample_us - line_seen_us < LINE_LOST_MS * 1000u) return 0;
+        // Ȱ󿴵ߵһ
+        Recover_Start(RECOVER_SRC_LOST, (last_valid_error > 0) ? -1 : ((last_valid_error < 0) ? 1 : 0), pose);
+        line_recover = 1;
+        Telemetry_Set_State(TLM_STATE_RECOVER);
+    }
+
+    // 2. ʧֱܺͣ˹ѳŻ
+    if (line_recover == 2)
+    {
+        left = 0;
+        right = 0;
+        if (line_seen)
+        {
+            Line_Tracker_Init();
+            Telemetry_Set_State(TLM_STATE_TRACK);
+            return 0;
+        }
+    }
+    else
+    {
+        switch (Recover_Step(pose, line_seen, &left, &right))
+        {
+            case RECOVER_FOUND:
+                // һ: ʷճѭ
+                Line_Tracker_Init();
+                Telemetry_Set_State(TLM_STATE_TRACK);
+                return 0;
+            case RECOVER_FAILED:
+                line_recover = 2;
+                break;
+            default:
+                break;
+        }
+    }
+
+    left = Apply_Dead_Zone(left);
+    right = Apply_Dead_Zone(right);
+    Car_Set_Speed(left, right);
+    Line_Log_Tick(error, yaw_rate, left, right, Car_Get_Cmd_Time_Us() - line_sample_us);
+    return 1;
+}
+#endif
+
+/* ·ڵɲͣ (˶ԭɻص) */
+static void Line_Junction_Stopped(uint8_t id, MOTION_RESULT_E result)
+{
+    line_junction = 2;
+}
+
+/* äת (˶ԭɻص)PIDʷ׼· */
+static void Line_Blind_Turn_Done(uint8_t id, MOTION_RESULT_E result)
+{
+    Line_Tracker_Init();
+    Telemetry_Set_State(TLM_STATE_TRACK);
+}
+
+/* ·ڶǰ: ת / ߹һ֮ L1  R1 ѹ· */
+static uint8_t Line_Branch_Seen(void)
+{
+    const ODOM_POSE_T *pose = Odom_Get();
+
+    if (line_turn_cmd == 3)
+    {
+        if (fabsf(pose->dist - line_turn_dist0) < STRAIGHT_EXIT_MIN_M) return 0;
+    }
+    else if (fabsf(pose->yaw - line_turn_yaw0) < TURN_EXIT_MIN_DEG)
+    {
+        return 0;
+    }
+    return (READ_L1 || READ_R1);
+}
+
+/* [] ִ·ת
  * ĿģӾָС롰ȫڡ򣬷ֹѭ
+ * ںϺ (ǻ + Уƫ ODOMETRY.c) ԭתĿ꺽֧·ѹ L1 / R1 ǰ
+ * ѹ˶ԭأ֮Ŀִ (ʱPID)ڼճº
  */
 static void Execute_Blind_Turn(uint8_t cmd)
 {
+    MOTION_CMD_T m = { .speed = TURN_SPEED, .time_ms = TURN_TIMEOUT_MS,
+                       .until = Line_Branch_Seen, .done = Line_Blind_Turn_Done };
+
     switch (cmd)
     {
         case 1: // ת (Left)
-            // ַת/ת
-            Car_Set_Speed(-TURN_SPEED, TURN_SPEED); 
+            // ַתת
+            m.type = MOTION_TURN;
+            m.value = TURN_ANGLE_DEG;
             break;
         
         case 2: // ת (Right)
-            // תַת/
-            Car_Set_Speed(TURN_SPEED, -TURN_SPEED); 
+            // תַת
+            m.type = MOTION_TURN;
+            m.value = -TURN_ANGLE_DEG;
             break;
         
         case 3: // ֱ (Straight)
-            Car_Set_Speed(TURN_SPEED, TURN_SPEED); 
+            m.type = MOTION_DRIVE;
+            m.value = STRAIGHT_DIST_M;
             break;
             
         default: // ЧָĬͣһ
             Car_Set_Speed(0, 0);
             return;
     }
-    
-    // ʱһʱóתȥ (ʽʱʱPID)
-    osDelay(TURN_DURATION_MS);
-    
-    // ɺPIDʷ׼·
-    Line_Tracker_Init();
+    line_turn_cmd = cmd;
+    line_turn_yaw0 = Odom_Get()->yaw;
+    line_turn_dist0 = Odom_Get()->dist;
+    Motion_Push(&m);
+    Telemetry_Set_State(TLM_STATE_BLIND_TURN);
 }
 
 /**
@@ -134,57 +377,118 @@ static void Execute_Blind_Turn(uint8_t cmd)
  */
 void Line_Tracker_PID_Action(void)
 {
+    int left, right;
+
     // ================= 1. ·ڼƽ =================
     //  L2  R2 ͬʱ (·)
-    if (READ_L2 && READ_R2 && !READ_L1 && !READ_R1) 
+    if (line_junction == 0 && !Motion_Busy() && READ_L2 && READ_R2 && !READ_L1 && !READ_R1) 
     {
-        // A. ͣ
-		Car_Set_Speed(-20, -20);
-		osDelay(100);
-        Car_Set_Speed(0, 0);
+        // A. ɲͣ (˶ԭĿʼִУͣȺص)
+        Motion_Hold(-JUNCTION_BACK_SPEED, -JUNCTION_BACK_SPEED, JUNCTION_BACK_MS, NULL);
+        Motion_Stop(0, Line_Junction_Stopped);
+        line_junction = 1;
+        Telemetry_Set_State(TLM_STATE_JUNCTION);
         
-        // B.  MVTASK (ͷ) 
-        
-        // C. ǰ񣬵ȴϢ
-        uint8_t turn_cmd = 0;      
-//		while(1);
-        if (osMessageQueueGet(MotorQueueHandle, &turn_cmd, NULL, osWaitForever) == osOK)
+        // B. K230 ʶ𣬽ӽ·ʱĽӾ (VISION.c)
+    }
+    else if (line_junction == 2)
+    {
+        // C. ͣȣȡӾ㹻µļͷûȴ½ MotorQueue ָ (ȼһڼ䲻м¼)
+        line_junction = 0;
+        Line_Log_Tick(0.0f, 0.0f, 0, 0, 0);
+        uint8_t turn_cmd = 0;
+        uint32_t queue_cmd = 0;     // MotorQueue ԪΪ uint32_t
+        while (!Vision_Get_Turn(VISION_MAX_AGE_MS, &turn_cmd))
         {
-            // D. յָִäת (·)
-            Execute_Blind_Turn(turn_cmd);
-            
-            return; 
+            if (osMessageQueueGet(MotorQueueHandle, &queue_cmd, NULL, VISION_WAIT_POLL_MS) == osOK)
+            {
+                turn_cmd = (uint8_t)queue_cmd;
+                break;
+            }
+        }
+        // D. ѹäת (·)Ŀʼִ
+        Execute_Blind_Turn(turn_cmd);
+    }
+
+    // ˶ԭִڼ䲻ѭճ (תĽǶȼ뺽)
+    if (Motion_Busy())
+    {
+        Odom_Update(MPU6050_Get_GyroZ_dps());
+        if (Motion_Tick(Odom_Get(), &left, &right))
+        {
+            Line_Log_Tick(0.0f, 0.0f, left, right, 0);
+            return;
         }
     }
     // ========================================================
     
 	
     // ================= 2.  PID ѭ߼ =================
-    // (´뱣ԭδ޸)
+    // (תʵּ STEER_CTRL.cлԭ PD Ա)
 	
-    // 1. ȡ
-    line_pid.error = Get_Line_Error();
-
-    // 2.  PID (PD㷨)
-    line_pid.output = (line_pid.error * PID_KP) + ((line_pid.error - line_pid.last_error) * PID_KD);
+    PROF_BEGIN(PROF_LINE_PID);
+    TRACE_MARK(TRACE_MARK_CTRL_TICK);
 
-    // 3. ʷ
-    line_pid.last_error = line_pid.error;
+    // 1. ȡ
+    float error = Get_Line_Error();
 
-    // 4. 㶯̬׼ٶ
-    int dynamic_base_speed = MAX_BASE_SPEED - (int)(fabsf(line_pid.error) * SPEED_DROP_FACTOR);
+    // 2. 㶯̬׼ٶ
+    int dynamic_base_speed = MAX_BASE_SPEED - (int)(fabsf(error) * SPEED_DROP_FACTOR);
     
     // СٶȲΪ
     if (dynamic_base_speed < 0) dynamic_base_speed = 0;
 
-    // 5. ϼҵĿٶ
-    int left_motor_target  = dynamic_base_speed + (int)line_pid.output;
-    int right_motor_target = dynamic_base_speed - (int)line_pid.output;
+    // 3. ת (水̬׼ٶȵȣdt ȡδʱ֮)
+    uint32_t period_us = line_sample_us - line_last_us;
+    float dt = (float)period_us / (float)TIMEBASE_HZ;
+    // Գʱȸ٣ºʱ CPU ˭ռ
+    if (line_last_us != 0 && period_us > TRACE_LATE_TICK_MS * 1000u)
+    {
+        Trace_Trigger(TRACE_TRIG_LATE_TICK);
+    }
+    line_last_us = line_sample_us;
+    if (dt < 0.001f) dt = 0.001f;
+    if (dt > 0.05f) dt = 0.05f;
+
+    // ٶÿĶ:  (ռդλ) Ҫĺ򣬶ȡʧʱһεĽٶ
+    float gyro_dps;
+    uint8_t gyro_ok = MPU6050_Read_GyroZ_dps(&gyro_dps);
+    float yaw_rate = 0.0f;
+#if LINE_STEER_SCHEDULED && LINE_STEER_USE_GYRO
+    // ȡʧ (I2C ռ / δУ׼) ʱǰ˲ǰֵǰ
+    yaw_rate = gyro_ok ? gyro_dps : line_steer.yaw_filt;
+#else
+    (void)gyro_ok;
+#endif
+    Odom_Update(gyro_dps);
+#if RECOVER_ENABLE
+    if (Line_Recover_Tick(error, yaw_rate))
+    {
+        PROF_END(PROF_LINE_PID);
+        return;
+    }
+#endif
+#if LANE_PREVIEW_ENABLE
+    Steer_Ctrl_Set_Preview(&line_steer, Line_Lane_Preview());
+#endif
+    PROF_BEGIN(PROF_STEER_UPDATE);
+    float output = Steer_Ctrl_Update(&line_steer, error, (float)dynamic_base_speed, yaw_rate, dt);
+    PROF_END(PROF_STEER_UPDATE);
+
+    // 4. ϼҵĿٶ
+    int left_motor_target  = dynamic_base_speed + (int)output;
+    int right_motor_target = dynamic_base_speed - (int)output;
 
-    // 6. 
+    // 5. 
     left_motor_target  = Apply_Dead_Zone(left_motor_target);
     right_motor_target = Apply_Dead_Zone(right_motor_target);
 
-    // 7. ·
+    // 6. ·
     Car_Set_Speed(left_motor_target, right_motor_target);
+
+    // 7. ң¼ (ָдӳ٣I2C ռд󲿷)
+    Line_Log_Tick(error, yaw_rate, left_motor_target, right_motor_target,
+                  Car_Get_Cmd_Time_Us() - line_sample_us);
+
+    PROF_END(PROF_LINE_PID);
 }
@@ -0,0 +1,115 @@
+#include "MONITOR.h"
+#include "TELEMETRY.h"
+#include "string.h"
+
+extern osMessageQueueId_t SG90QueueHandle;
+extern osMessageQueueId_t MVQueueHandle;
+extern osMessageQueueId_t MotorQueueHandle;
+extern osMessageQueueId_t OLEDQueueHandle;
+
+static TaskStatus_t mon_status[MON_MAX_TASKS];
+/* 上个周期各任务的运行时间计数，按句柄对应 */
+static TaskHandle_t mon_prev_handle[MON_MAX_TASKS];
+static uint32_t mon_prev_counter[MON_MAX_TASKS];
+static uint32_t mon_prev_total = 0;
+static uint8_t mon_stack_warn = 0;
+
+/**
+ * @brief 返回任务上个周期的运行时间计数，并记下本周期的值
+ */
+static uint32_t Monitor_Swap_Counter(TaskHandle_t handle, uint32_t counter)
+{
+    uint8_t free_slot = MON_MAX_TASKS;
+    for (uint8_t i = 0; i < MON_MAX_TASKS; i++)
+    {
+        if (mon_prev_handle[i] == handle)
+        {
+            uint32_t prev = mon_prev_counter[i];
+            mon_prev_counter[i] = counter;
+            return prev;
+        }
+        if (mon_prev_handle[i] == NULL && free_slot == MON_MAX_TASKS) free_slot = i;
+    }
+    // 新任务：从 0 开始计
+    if (free_slot < MON_MAX_TASKS)
+    {
+        mon_prev_handle[free_slot] = handle;
+        mon_prev_counter[free_slot] = counter;
+    }
+    return 0;
+}
+
+static uint8_t Monitor_Clamp_U8(uint32_t x)
+{
+    return (x > 255) ? 255 : (uint8_t)x;
+}
+
+void Monitor_Sample(void)
+{
+    static osMessageQueueId_t *const queues[4] = { &SG90QueueHandle, &MVQueueHandle, &MotorQueueHandle, &OLEDQueueHandle };
+    TaskHandle_t idle_handle = xTaskGetIdleTaskHandle();
+    uint32_t total = 0;
+    uint32_t dt_total;
+    uint16_t idle = 0;
+    uint8_t warn = 0;
+    UBaseType_t n;
+    TLM_SLOT_T *slot;
+
+    // 1. 一次取全部任务状态 (期间调度器挂起，约几十 us)
+    n = uxTaskGetSystemState(mon_status, MON_MAX_TASKS, &total);
+    dt_total = total - mon_prev_total;
+    mon_prev_total = total;
+
+    // 2. 每个任务一条记录
+    for (UBaseType_t i = 0; i < n; i++)
+    {
+        TaskStatus_t *t = &mon_status[i];
+        uint32_t delta = t->ulRunTimeCounter - Monitor_Swap_Counter(t->xHandle, t->ulRunTimeCounter);
+        uint16_t cpu = (dt_total == 0) ? 0 : (uint16_t)((uint64_t)delta * 1000u / dt_total);
+        uint8_t flags = 0;
+
+        if (t->usStackHighWaterMark < MON_STACK_WARN_WORDS)
+        {
+            flags |= MON_FLAG_STACK_LOW;
+            warn++;
+        }
+        if (t->xHandle == idle_handle)
+        {
+            flags |= MON_FLAG_IDLE;
+            idle = cpu;
+        }
+
+        slot = Telemetry_Service_Begin();
+        strncpy(slot->task.name, t->pcTaskName, sizeof(slot->task.name));
+        slot->task.cpu = cpu;
+        slot->task.stack_free = t->usStackHighWaterMark;
+        slot->task.priority = Monitor_Clamp_U8(t->uxCurrentPriority);
+        slot->task.state = (uint8_t)t->eCurrentState;
+        slot->task.number = Monitor_Clamp_U8(t->xTaskNumber);
+        slot->task.flags = flags;
+        memset(slot->task.reserved, 0, sizeof(slot->task.reserved));
+        Telemetry_Service_Commit(slot, TLM_TYPE_TASK);
+    }
+    mon_stack_warn = warn;
+
+    // 3. 系统记录：堆、队列
+    slot = Telemetry_Service_Begin();
+    slot->sys.heap_free = xPortGetFreeHeapSize();
+    slot->sys.heap_min = xPortGetMinimumEverFreeHeapSize();
+    slot->sys.idle = idle;
+    slot->sys.task_count = Monitor_Clamp_U8(uxTaskGetNumberOfTasks());
+    slot->sys.stack_warn = warn;
+    for (uint8_t q = 0; q < 4; q++)
+    {
+        osMessageQueueId_t handle = *queues[q];
+        slot->sys.queue_used[q] = (handle == NULL) ? 0 : Monitor_Clamp_U8(osMessageQueueGetCount(handle));
+        slot->sys.queue_size[q] = (handle == NULL) ? 0 : Monitor_Clamp_U8(osMessageQueueGetCapacity(handle));
+    }
+    memset(slot->sys.reserved, 0, sizeof(slot->sys.reserved));
+    Telemetry_Service_Commit(slot, TLM_TYPE_SYS);
+}
+
+uint8_t Monitor_Get_Stack_Warn(void)
+{
+    return mon_stack_warn;
+}
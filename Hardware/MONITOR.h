@@ -0,0 +1,26 @@
+#ifndef __MONITOR_H
+#define __MONITOR_H
+
+#include "main.h"
+
+/*
+ * 运行监控：每 MON_PERIOD_MS 统计一次各任务 CPU 占用、栈余量、堆余量和队列深度，
+ * 以 TLM_TASK_T / TLM_SYS_T 记录写入遥测服务缓冲 (Tools/tlm_decode.py 解码)
+ * 依赖 configGENERATE_RUN_TIME_STATS (TIM5 1MHz 计数) 和 configUSE_TRACE_FACILITY
+ */
+
+#define MON_PERIOD_MS           1000
+#define MON_MAX_TASKS           16      // 必须不少于任务总数 (含 IDLE / Tmr Svc)，否则取不到统计
+#define MON_STACK_WARN_WORDS    32      // 栈历史最小剩余低于 32 字 (128B) 时告警
+
+/* TLM_TASK_T.flags */
+#define MON_FLAG_STACK_LOW      0x01    // 栈余量低于 MON_STACK_WARN_WORDS
+#define MON_FLAG_IDLE           0x02    // 空闲任务
+
+void Monitor_Sample(void);
+/**
+ * @brief 最近一次统计中栈余量不足的任务数 (可供 OLED 等显示告警)
+ */
+uint8_t Monitor_Get_Stack_Warn(void);
+
+#endif // __MONITOR_H
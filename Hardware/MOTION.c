@@ -0,0 +1,230 @@
+#include "MOTION.h"
+#include "MOTOR.h"
+#include "TIMEBASE.h"
+#include "main.h"
+#include "math.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+#define MOTION_MASK         (MOTION_QUEUE_SIZE - 1)
+#define MOTION_RUNNING      0xFF
+
+typedef struct
+{
+    MOTION_CMD_T cmd;
+    uint8_t id;
+} MOTION_SLOT_T;
+
+/* 队列: head / tail 为自由计数 (取模访问)，head 只由 Motion_Tick 修改，tail 只由 Motion_Push 修改 */
+static MOTION_SLOT_T motion_queue[MOTION_QUEUE_SIZE];
+static volatile uint8_t motion_head = 0;
+static volatile uint8_t motion_tail = 0;
+static volatile uint8_t motion_abort = 0;       // Motion_Clear 请求
+static volatile uint8_t motion_abort_to = 0;    // 清除到该位置为止 (不含之后压入的)
+static uint8_t motion_next_id = 0;
+static volatile uint8_t motion_last_done = 0;
+
+/* 执行中的原语 (只在调用 Motion_Tick 的任务中访问) */
+static MOTION_SLOT_T motion_cur;
+static volatile uint8_t motion_active = 0;
+static float motion_start_dist;
+static float motion_start_yaw;
+static uint32_t motion_start_us;
+
+static void Motion_Finish(const MOTION_SLOT_T *slot, MOTION_RESULT_E result)
+{
+    motion_last_done = slot->id;
+    if (slot->cmd.done != NULL) slot->cmd.done(slot->id, result);
+}
+
+/**
+ * @brief 距终点 remain 以内按比例减速，不低于 MOTION_MIN_SPEED
+ */
+static int Motion_Ramp(int speed, float remain, float slow)
+{
+    if (remain >= slow || speed <= MOTION_MIN_SPEED) return speed;
+    return MOTION_MIN_SPEED + (int)((float)(speed - MOTION_MIN_SPEED) * remain / slow);
+}
+
+/**
+ * @brief 执行一拍
+ * @return MOTION_RUNNING 或结束原因 (MOTION_RESULT_E)
+ */
+static uint8_t Motion_Step(const MOTION_CMD_T *c, const ODOM_POSE_T *pose, int *left, int *right)
+{
+    uint32_t elapsed_ms = Timebase_Elapsed_Us(motion_start_us) / 1000u;
+    float sign = (c->value < 0.0f) ? -1.0f : 1.0f;
+    int speed = (c->speed < 0) ? -c->speed : c->speed;
+    float remain, k;
+    int turn;
+
+    // 1. 开环原语: 按时间结束
+    if (c->type == MOTION_STOP || c->type == MOTION_HOLD)
+    {
+        *left = (c->type == MOTION_HOLD) ? c->left : 0;
+        *right = (c->type == MOTION_HOLD) ? c->right : 0;
+        return (elapsed_ms >= c->time_ms) ? MOTION_OK : MOTION_RUNNING;
+    }
+
+    // 2. 闭环原语: 先查提前结束条件和超时
+    if (c->until != NULL && c->until()) return MOTION_EXIT;
+    if (elapsed_ms >= (c->time_ms ? c->time_ms : MOTION_TIMEOUT_MS)) return MOTION_TIMEOUT;
+
+    switch (c->type)
+    {
+        case MOTION_DRIVE:
+            // 保持起始航向，后退时差速方向不变 (角速度只取决于右轮减左轮)
+            remain = fabsf(c->value) - fabsf(pose->dist - motion_start_dist);
+            if (remain <= 0.0f) return MOTION_OK;
+            speed = Motion_Ramp(speed, remain, MOTION_SLOW_M);
+            if (c->speed < 0) speed = -speed;
+            turn = (int)(MOTION_HEADING_KP * (motion_start_yaw - pose->yaw));
+            if (turn > MOTION_TURN_MAX) turn = MOTION_TURN_MAX;
+            if (turn < -MOTION_TURN_MAX) turn = -MOTION_TURN_MAX;
+            *left = speed - turn;
+            *right = speed + turn;
+            break;
+
+        case MOTION_TURN:
+            remain = fabsf(c->value) - sign * (pose->yaw - motion_start_yaw);
+            if (remain <= MOTION_TURN_LEAD_DEG) return MOTION_OK;
+            speed = Motion_Ramp(speed, remain - MOTION_TURN_LEAD_DEG, MOTION_SLOW_DEG);
+            *left = -(int)sign * speed;
+            *right = (int)sign * speed;
+            break;
+
+        case MOTION_ARC:
+            // 外侧轮取 speed，内侧轮按半径比例: v_in / v_out = (R - T/2) / (R + T/2)
+            remain = fabsf(c->value) - sign * (pose->yaw - motion_start_yaw);
+            if (remain <= MOTION_TURN_LEAD_DEG) return MOTION_OK;
+            speed = Motion_Ramp(speed, remain - MOTION_TURN_LEAD_DEG, MOTION_SLOW_DEG);
+            k = (c->radius - 0.5f * MOTION_TRACK_M) / (c->radius + 0.5f * MOTION_TRACK_M);
+            *left = (sign > 0.0f) ? (int)(k * (float)speed) : speed;
+            *right = (sign > 0.0f) ? speed : (int)(k * (float)speed);
+            break;
+
+        default:
+            return MOTION_ABORT;
+    }
+    return MOTION_RUNNING;
+}
+
+uint8_t Motion_Push(const MOTION_CMD_T *cmd)
+{
+    uint8_t id = 0;
+
+    taskENTER_CRITICAL();
+    if ((uint8_t)(motion_tail - motion_head) < MOTION_QUEUE_SIZE)
+    {
+        if (++motion_next_id == 0) motion_next_id = 1;
+        id = motion_next_id;
+        motion_queue[motion_tail & MOTION_MASK].cmd = *cmd;
+        motion_queue[motion_tail & MOTION_MASK].id = id;
+        motion_tail++;
+    }
+    taskEXIT_CRITICAL();
+    return id;
+}
+
+uint8_t Motion_Stop(uint16_t time_ms, MOTION_DONE_FN done)
+{
+    MOTION_CMD_T c = { .type = MOTION_STOP, .time_ms = time_ms, .done = done };
+    return Motion_Push(&c);
+}
+
+uint8_t Motion_Hold(int8_t left, int8_t right, uint16_t time_ms, MOTION_DONE_FN done)
+{
+    MOTION_CMD_T c = { .type = MOTION_HOLD, .left = left, .right = right, .time_ms = time_ms, .done = done };
+    return Motion_Push(&c);
+}
+
+uint8_t Motion_Drive(float dist_m, int8_t speed, MOTION_DONE_FN done)
+{
+    MOTION_CMD_T c = { .type = MOTION_DRIVE, .speed = speed, .value = dist_m, .done = done };
+    return Motion_Push(&c);
+}
+
+uint8_t Motion_Turn(float angle_deg, int8_t speed, MOTION_DONE_FN done)
+{
+    MOTION_CMD_T c = { .type = MOTION_TURN, .speed = speed, .value = angle_deg, .done = done };
+    return Motion_Push(&c);
+}
+
+uint8_t Motion_Arc(float radius_m, float angle_deg, int8_t speed, MOTION_DONE_FN done)
+{
+    MOTION_CMD_T c = { .type = MOTION_ARC, .speed = speed, .value = angle_deg, .radius = radius_m, .done = done };
+    return Motion_Push(&c);
+}
+
+void Motion_Clear(void)
+{
+    taskENTER_CRITICAL();
+    motion_abort_to = motion_tail;
+    motion_abort = 1;
+    taskEXIT_CRITICAL();
+}
+
+uint8_t Motion_Busy(void)
+{
+    return (motion_active || motion_head != motion_tail);
+}
+
+uint8_t Motion_Last_Done(void)
+{
+    return motion_last_done;
+}
+
+uint8_t Motion_Tick(const ODOM_POSE_T *pose, int *left, int *right)
+{
+    MOTION_SLOT_T slot;
+    uint8_t abort_to, result;
+    uint8_t wrote = 0;
+
+    // 1. 清除请求: 执行中的和清除前压入的都以 MOTION_ABORT 结束
+    if (motion_abort)
+    {
+        taskENTER_CRITICAL();
+        abort_to = motion_abort_to;
+        motion_abort = 0;
+        taskEXIT_CRITICAL();
+        if (motion_active)
+        {
+            motion_active = 0;
+            Motion_Finish(&motion_cur, MOTION_ABORT);
+        }
+        while ((int8_t)(abort_to - motion_head) > 0)
+        {
+            slot = motion_queue[motion_head & MOTION_MASK];
+            motion_head++;
+            Motion_Finish(&slot, MOTION_ABORT);
+        }
+    }
+
+    // 2. 执行当前原语；结束时本拍接着开始下一条。闭环原语到位的那一拍不写电机:
+    //    后面没有原语时电机保持上一拍的输出，由调用者 (循迹) 本拍接手
+    for (uint8_t n = 0; n <= MOTION_QUEUE_SIZE; n++)
+    {
+        if (!motion_active)
+        {
+            if (motion_head == motion_tail) return wrote;
+            motion_cur = motion_queue[motion_head & MOTION_MASK];
+            motion_head++;
+            motion_active = 1;
+            motion_start_dist = pose->dist;
+            motion_start_yaw = pose->yaw;
+            motion_start_us = Timebase_Now_Us();
+        }
+
+        result = Motion_Step(&motion_cur.cmd, pose, left, right);
+        if (result == MOTION_RUNNING || motion_cur.cmd.type <= MOTION_HOLD)
+        {
+            Car_Set_Speed(*left, *right);
+            wrote = 1;
+        }
+        if (result == MOTION_RUNNING) return 1;
+
+        motion_active = 0;
+        Motion_Finish(&motion_cur, (MOTION_RESULT_E)result);
+    }
+    return wrote;
+}
@@ -0,0 +1,87 @@
+#ifndef __MOTION_H
+#define __MOTION_H
+
+#include "stdint.h"
+#include "ODOMETRY.h"
+
+/*
+ * 运动原语执行器
+ * 上层把动作 (直行一段距离 / 原地转过一个角度 / 圆弧 / 停车 / 定速保持) 压入队列后立即返回，
+ * 由循迹任务的控制周期调用 Motion_Tick 按里程计位姿逐拍执行，不阻塞任何任务 (取代原 HAL_Delay 的 Car_* 函数)。
+ * 每条原语结束 (到位 / 条件满足 / 超时 / 被清除) 时在控制周期内调用其完成回调，并记下最近完成的编号。
+ * 队列为空时 Motion_Tick 不写电机，由循迹照常控制；需要停车时以 MOTION_STOP 结尾。
+ * 距离取编码器路程，角度取陀螺仪积分航向 (ODOMETRY.c)；调用 Motion_Tick 之前需先 Odom_Update。
+ */
+
+#define MOTION_QUEUE_SIZE       8       // 必须为 2 的幂
+#define MOTION_TRACK_M          0.150f  // 轮距，圆弧半径 -> 左右轮速比
+#define MOTION_MIN_SPEED        18      // 电机死区，减速段不低于该 PWM
+#define MOTION_HEADING_KP       1.0f    // 直行保持航向: 航向误差 (deg) -> 差速 PWM
+#define MOTION_TURN_MAX         20      // 直行差速上限
+#define MOTION_SLOW_M           0.05f   // 直行最后这段距离减速到 MOTION_MIN_SPEED
+#define MOTION_SLOW_DEG         20.0f   // 转向最后这段角度减速到 MOTION_MIN_SPEED
+#define MOTION_TURN_LEAD_DEG    3.0f    // 转向提前结束的角度 (停转后惯性滑过)
+#define MOTION_TIMEOUT_MS       3000u   // 直行 / 转向 / 圆弧未指定超时时的默认值
+
+typedef enum
+{
+    MOTION_STOP = 0,        // 停车 time_ms
+    MOTION_HOLD,            // 左右轮定速 time_ms (开环)
+    MOTION_DRIVE,           // 保持起始航向直行 value 米 (speed < 0 后退)
+    MOTION_TURN,            // 原地转过 value 度 (左正)
+    MOTION_ARC              // 沿半径 radius 的圆弧转过 value 度 (左正)
+} MOTION_TYPE_E;
+
+typedef enum
+{
+    MOTION_OK = 0,          // 到位 / 时间到
+    MOTION_EXIT,            // until 条件满足，提前结束
+    MOTION_TIMEOUT,
+    MOTION_ABORT            // 被 Motion_Clear 清除
+} MOTION_RESULT_E;
+
+typedef void (*MOTION_DONE_FN)(uint8_t id, MOTION_RESULT_E result);
+typedef uint8_t (*MOTION_UNTIL_FN)(void);
+
+typedef struct
+{
+    uint8_t type;           // MOTION_TYPE_E
+    int8_t speed;           // PWM，DRIVE 为负时后退；TURN / ARC 取绝对值
+    int8_t left, right;     // HOLD 的左右轮 PWM
+    uint16_t time_ms;       // STOP / HOLD 的持续时间；其他类型为超时，0 取 MOTION_TIMEOUT_MS
+    float value;            // DRIVE: 距离 (m)；TURN / ARC: 角度 (deg，左正)
+    float radius;           // ARC: 车身中心的圆弧半径 (m)，须大于 MOTION_TRACK_M / 2
+    MOTION_UNTIL_FN until;  // 每拍检查，返回非 0 即提前结束 (可为 NULL)
+    MOTION_DONE_FN done;    // 完成回调，在 Motion_Tick 中调用 (可为 NULL)
+} MOTION_CMD_T;
+
+/**
+ * @brief 压入一条原语
+ * @return 原语编号 (1~255 循环)，队列满返回 0
+ */
+uint8_t Motion_Push(const MOTION_CMD_T *cmd);
+uint8_t Motion_Stop(uint16_t time_ms, MOTION_DONE_FN done);
+uint8_t Motion_Hold(int8_t left, int8_t right, uint16_t time_ms, MOTION_DONE_FN done);
+uint8_t Motion_Drive(float dist_m, int8_t speed, MOTION_DONE_FN done);
+uint8_t Motion_Turn(float angle_deg, int8_t speed, MOTION_DONE_FN done);
+uint8_t Motion_Arc(float radius_m, float angle_deg, int8_t speed, MOTION_DONE_FN done);
+/**
+ * @brief 清空队列，执行中的原语以 MOTION_ABORT 结束 (回调在下一次 Motion_Tick 中调用)；不停车
+ */
+void Motion_Clear(void);
+/**
+ * @brief 有原语在执行或排队
+ */
+uint8_t Motion_Busy(void);
+/**
+ * @brief 最近一条完成的原语编号，0 表示还没有
+ */
+uint8_t Motion_Last_Done(void);
+/**
+ * @brief 执行一拍，每个控制周期在 Odom_Update 之后调用
+ * @param left / right 输出本拍写入电机的 PWM
+ * @return 1: 本拍由执行器写了电机; 0: 空闲，或闭环原语到位且队列已空 (电机保持上一拍输出，由调用者接手)
+ */
+uint8_t Motion_Tick(const ODOM_POSE_T *pose, int *left, int *right);
+
+#endif // __MOTION_H
@@ -1,4 +1,5 @@
 #include "MOTOR.h"
+#include "TIMEBASE.h"
 
 // TIM9Զװֵ (ARR)  999ôPWMռձȷΧ 0-999
 // ڽ 0-100 ٶֵӳ䵽 0-ARR ıȽֵ
@@ -9,6 +10,8 @@
 // ڲٶȺͷ
 static void robot_speed(int left_speed, int right_speed);
 
+static uint32_t motor_cmd_us = 0;   // һд PWM Ƚֵʱ (TIMEBASE ΢)
+
 /**
  * @brief PWM
  */
@@ -54,106 +57,6 @@ static void robot_speed(int left_speed, int right_speed)
 }
 
 
-/**
- * @brief Сǰ
- * @param speed ٶ (0-100)
- * @param time ʱ ()
- */
-void Car_Run(int8_t speed, uint16_t time)
-{
-    if (speed > 100) speed = 100;
-    if (speed < 0) speed = 0;
-    
-    robot_speed(speed, speed);
-    HAL_Delay(time); // ʹHALʱ
-}
-
-/**
- * @brief С
- * @param speed ٶ (0-100)
- * @param time ʱ ()
- */
-void Car_Back(int8_t speed, uint16_t time)
-{
-    if (speed > 100) speed = 100;
-    if (speed < 0) speed = 0;
-
-    robot_speed(-speed, -speed);
-    HAL_Delay(time);
-    robot_speed(0, 0); // нֹͣ
-}
-
-/**
- * @brief Сɲ
- * @param time ʱ ()
- */
-void Car_Brake(uint16_t time)
-{
-    robot_speed(0, 0);
-    HAL_Delay(time);
-}
-
-/**
- * @brief Сת (ԭ)
- * @param speed ٶ (0-100)
- * @param time ʱ ()
- */
-void Car_Spin_Left(int8_t speed, uint16_t time)
-{
-    if (speed > 100) speed = 100;
-    if (speed < 0) speed = 0;
-
-    robot_speed(-speed, speed); // ֺˣǰ
-    HAL_Delay(time);
-    robot_speed(0, 0); // нֹͣ
-}
-
-/**
- * @brief Сת (ԭ)
- * @param speed ٶ (0-100)
- * @param time ʱ ()
- */
-void Car_Spin_Right(int8_t speed, uint16_t time)
-{
-    if (speed > 100) speed = 100;
-    if (speed < 0) speed = 0;
-
-    robot_speed(speed, -speed); // ǰֺ
-    HAL_Delay(time);
-    robot_speed(0, 0); // нֹͣ
-}
-
-/**
- * @brief Сת ()
- * @param speed ٶ (0-100)
- * @param time ʱ ()
- */
-void Car_Left(int8_t speed, uint16_t time)
-{
-    if (speed > 100) speed = 100;
-    if (speed < 0) speed = 0;
-
-    // ֿ죬ʵת
-    robot_speed(speed / 2, speed); 
-    HAL_Delay(time);
-    robot_speed(0, 0);
-}
-
-/**
- * @brief Сת ()
- * @param speed ٶ (0-100)
- * @param time ʱ ()
- */
-void Car_Right(int8_t speed, uint16_t time)
-{
-    if (speed > 100) speed = 100;
-    if (speed < 0) speed = 0;
-
-    // ֿ죬ʵת
-    robot_speed(speed, speed / 2);
-    HAL_Delay(time);
-    robot_speed(0, 0);
-}
 /* @brief ٶȺͷ (ʱ)
 * @param left_speed  ٶ (-100  100, ʾ)
 * @param right_speed ٶ (-100  100, ʾ)
@@ -167,4 +70,13 @@ void Car_Set_Speed(int left_speed, int right_speed)
     if (right_speed < -100) right_speed = -100;
 
     robot_speed(left_speed, right_speed);
+    motor_cmd_us = Timebase_Now_Us();
+}
+
+/**
+ * @brief һ Car_Set_Speed д PWM ʱ (TIMEBASE ΢)
+ */
+uint32_t Car_Get_Cmd_Time_Us(void)
+{
+    return motor_cmd_us;
 }
\ No newline at end of file
@@ -28,58 +28,20 @@ extern TIM_HandleTypeDef htim9;
  */
 void Motor_Start(void);
 
-/**
- * @brief Сǰ
- * @param speed ٶ (0-100)
- * @param time ʱ ()
- */
-void Car_Run(int8_t speed, uint16_t time);
-
-/**
- * @brief С
- * @param speed ٶ (0-100)
- * @param time ʱ ()
- */
-void Car_Back(int8_t speed, uint16_t time);
-
-/**
- * @brief Сɲ
- * @param time ʱ ()
- */
-void Car_Brake(uint16_t time);
-
-/**
- * @brief Сת (ԭ)
- * @param speed ٶ (0-100)
- * @param time ʱ ()
+/*
+ * ԭ Car_Run / Car_Back / Car_Brake / Car_Spin_* / Car_Left / Car_Right  HAL_Delay æȼʱ
+ * ˶ԭ (MOTION.h) ȡ: Motion_Drive / Motion_Turn / Motion_Arc / Motion_Stop / Motion_Hold
  */
-void Car_Spin_Left(int8_t speed, uint16_t time);
 
-/**
- * @brief Сת (ԭ)
- * @param speed ٶ (0-100)
- * @param time ʱ ()
- */
-void Car_Spin_Right(int8_t speed, uint16_t time);
-
-/**
- * @brief Сת (뾶)
- * @param speed ٶ (0-100)
- * @param time ʱ ()
- */
-void Car_Left(int8_t speed, uint16_t time);
-
-/**
- * @brief Сת (뾶)
- * @param speed ٶ (0-100)
- * @param time ʱ ()
- */
-void Car_Right(int8_t speed, uint16_t time);
 /**
  * @brief ٶȺͷ (ʱ)
  * @param left_speed  ٶ (-100  100, ʾ)
  * @param right_speed ٶ (-100  100, ʾ)
  */
 void Car_Set_Speed(int left_speed, int right_speed);
+/**
+ * @brief һ Car_Set_Speed д PWM ʱ (TIMEBASE ΢)
+ */
+uint32_t Car_Get_Cmd_Time_Us(void);
 #endif // __MOTOR_H
 
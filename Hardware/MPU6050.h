@@ -38,9 +38,10 @@ extern MPU6050_T g_tMPU6050;
 
 /* º¯ÊýÉùÃ÷ */
 void MPU6050_Init(void);
-void MPU6050_ReadData(void);
+uint8_t MPU6050_ReadData(void);
 uint8_t MPU6050_ReadID(void);
+uint32_t MPU6050_Get_Sample_Time_Us(void);
+uint8_t MPU6050_Read_GyroZ_dps(float *dps);
+float MPU6050_Get_GyroZ_dps(void);
 void MPU6050_Calibrate_Z(void);
-void MPU6050_Turn_Angle(float target_angle, int speed);
-void Car_Go_Straight_Gyro_Integration(int16_t Speed, uint32_t Time_ms,uint32_t sharpbrake_time);
 #endif
\ No newline at end of file
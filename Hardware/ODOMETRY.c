@@ -0,0 +1,86 @@
+#include "ODOMETRY.h"
+#include "main.h"
+#include "math.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+#define ODOM_DEG2RAD    0.017453293f
+#define ODOM_RAD2DEG    57.29578f
+
+extern TIM_HandleTypeDef htim2;
+extern TIM_HandleTypeDef htim3;
+
+static ODOM_POSE_T odom;
+static uint16_t odom_cnt_l = 0;
+static uint16_t odom_cnt_r = 0;
+
+void Odom_Init(void)
+{
+    HAL_TIM_Encoder_Start(&htim2, TIM_CHANNEL_ALL);
+    HAL_TIM_Encoder_Start(&htim3, TIM_CHANNEL_ALL);
+    Odom_Reset();
+}
+
+void Odom_Reset(void)
+{
+    odom.x = odom.y = odom.yaw = odom.dist = odom.v = 0.0f;
+    odom.time_us = Timebase_Now_Us();
+    odom_cnt_l = (uint16_t)__HAL_TIM_GET_COUNTER(&htim2);
+    odom_cnt_r = (uint16_t)__HAL_TIM_GET_COUNTER(&htim3);
+}
+
+void Odom_Update(float yaw_rate_dps)
+{
+    uint32_t now = Timebase_Now_Us();
+    uint16_t cnt_l = (uint16_t)__HAL_TIM_GET_COUNTER(&htim2);
+    uint16_t cnt_r = (uint16_t)__HAL_TIM_GET_COUNTER(&htim3);
+    float dt = (float)(now - odom.time_us) / (float)TIMEBASE_HZ;
+
+    // 1. 编码器增量 (16 位计数器，按有符号差处理回绕)
+    float dl = (float)((int16_t)(cnt_l - odom_cnt_l) * ODOM_LEFT_DIR) / ODOM_COUNTS_PER_M;
+    float dr = (float)((int16_t)(cnt_r - odom_cnt_r) * ODOM_RIGHT_DIR) / ODOM_COUNTS_PER_M;
+    float ds = 0.5f * (dl + dr);
+    odom_cnt_l = cnt_l;
+    odom_cnt_r = cnt_r;
+    odom.time_us = now;
+
+    // 2. 陀螺仪零偏: 近似直行 / 静止且与编码器角速度一致时，两者之差低通即为零偏
+    if (dt > 0.0f && dt <= ODOM_MAX_DT)
+    {
+        float enc_rate = (dr - dl) / ODOM_TRACK_M / dt * ODOM_RAD2DEG;
+        float diff = yaw_rate_dps - enc_rate;
+
+        if (fabsf(enc_rate) < ODOM_BIAS_RATE_MAX && fabsf(diff - odom.gyro_bias) < ODOM_SLIP_DPS)
+        {
+            odom.gyro_bias += (dt / ODOM_BIAS_TAU_S) * (diff - odom.gyro_bias);
+            if (odom.gyro_bias > ODOM_BIAS_MAX) odom.gyro_bias = ODOM_BIAS_MAX;
+            if (odom.gyro_bias < -ODOM_BIAS_MAX) odom.gyro_bias = -ODOM_BIAS_MAX;
+        }
+    }
+
+    // 3. 航向积分，位置按本步中点航向投影
+    float dyaw = (yaw_rate_dps - odom.gyro_bias) * ((dt > ODOM_MAX_DT) ? ODOM_MAX_DT : dt);
+    float yaw_mid = (odom.yaw + 0.5f * dyaw) * ODOM_DEG2RAD;
+    odom.x += ds * cosf(yaw_mid);
+    odom.y += ds * sinf(yaw_mid);
+    odom.yaw += dyaw;
+    odom.dist += ds;
+
+    // 4. 车速
+    if (dt > 0.0f)
+    {
+        odom.v += ODOM_V_ALPHA * (ds / dt - odom.v);
+    }
+}
+
+const ODOM_POSE_T *Odom_Get(void)
+{
+    return &odom;
+}
+
+void Odom_Copy(ODOM_POSE_T *out)
+{
+    taskENTER_CRITICAL();
+    *out = odom;
+    taskEXIT_CRITICAL();
+}
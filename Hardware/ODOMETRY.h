@@ -0,0 +1,60 @@
+#ifndef __ODOMETRY_H
+#define __ODOMETRY_H
+
+#include "stdint.h"
+
+/*
+ * 航迹推算
+ * 路程: TIM2 (左轮 PA5/PA1) / TIM3 (右轮 PA6/PC7) 编码器模式，A/B 相 4 倍频计数
+ * 航向: MPU6050 Z 轴角速度积分。差速求航向受打滑影响大，不直接积分，只在近似直行 / 静止且两者一致 (不打滑) 时
+ *       与陀螺仪角速度比较，低通估计陀螺仪零偏 (互补滤波: 高频取陀螺仪，低频由编码器校正)，补偿上电标定后的温漂
+ * 坐标系: Odom_Reset 时的位置为原点，x 沿当时的车头方向，y 向左，航向左转为正 (与陀螺仪一致)
+ * 循迹任务每个控制周期 (盲转期间也不间断) 调用 Odom_Update，循迹挂起期间由避障任务调用；
+ * 两次调用之间轮子转过的计数不能超过 32767 (约 2.7m)
+ */
+
+#define ODOM_COUNTS_PER_M   12230.0f    // 13 线霍尔 x4 倍频 x 1:48 减速 / (65mm 轮 x π)，需实测: 推车直行 1m 读计数
+#define ODOM_LEFT_DIR       1           // 前进时计数减小的一侧改为 -1
+#define ODOM_RIGHT_DIR      1
+#define ODOM_MAX_DT         0.05f       // 航向积分的最大步长 (s)，调用间隔过长时不按长间隔积分
+#define ODOM_V_ALPHA        0.3f        // 速度一阶低通系数
+#define ODOM_TRACK_M        0.150f      // 轮距，差速 -> 角速度
+#define ODOM_BIAS_TAU_S     5.0f        // 零偏估计时间常数 (平均掉编码器 10ms 量化带来的约 3°/s 噪声)
+#define ODOM_BIAS_RATE_MAX  10.0f       // 编码器角速度小于该值 (直行 / 静止) 才估计零偏，避免轮距误差在转弯时带入
+#define ODOM_SLIP_DPS       15.0f       // 陀螺仪与编码器角速度差超过该值视为打滑，不估计
+#define ODOM_BIAS_MAX       5.0f        // 零偏估计限幅 (deg/s)
+
+typedef struct
+{
+    float x;                // m
+    float y;                // m
+    float yaw;              // deg
+    float dist;             // 累计行驶路程 (m)，后退为负
+    float v;                // 车速 (m/s)，低通
+    float gyro_bias;        // 在线估计的陀螺仪零偏 (deg/s)，已从航向积分中扣除
+    uint32_t time_us;       // 最近一次更新的时刻 (TIMEBASE 微秒)
+} ODOM_POSE_T;
+
+/**
+ * @brief 启动两路编码器计数，在 MX_TIM2_Init / MX_TIM3_Init 之后调用
+ */
+void Odom_Init(void);
+/**
+ * @brief 位姿清零，以当前位置和车头方向为原点
+ */
+void Odom_Reset(void);
+/**
+ * @brief 读取编码器增量并积分位姿
+ * @param yaw_rate_dps Z 轴角速度 (deg/s，左转为正)，由调用者读取 (MPU6050_Get_GyroZ_dps)，零偏在此扣除
+ */
+void Odom_Update(float yaw_rate_dps);
+/**
+ * @brief 位姿指针，只在调用 Odom_Update 的任务中使用
+ */
+const ODOM_POSE_T *Odom_Get(void);
+/**
+ * @brief 位姿拷贝 (临界区内)，其他任务读取位姿用
+ */
+void Odom_Copy(ODOM_POSE_T *out);
+
+#endif // __ODOMETRY_H
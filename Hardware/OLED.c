@@ -1,5 +1,6 @@
 #include "OLED.h"
 #include "OLED_Font.h"
+#include "PROFILE.h"
 
 const uint8_t Init_Command[]=
 {
@@ -48,10 +49,12 @@ void OLED_DispChar(uint8_t Row,uint8_t Col,char Char,uint8_t Size)
 
 void OLED_DispString(uint8_t Row,uint8_t Col,char Char[],uint8_t Size)
 {
+	PROF_BEGIN(PROF_OLED_STRING);
 	uint8_t n=strlen(Char);
 	for(uint8_t i=0;i<n;i++){
 		OLED_DispChar(Row,Col+i,Char[i],Size);
 	}
+	PROF_END(PROF_OLED_STRING);
 }
 void OLED_DispUNum(uint8_t Row, uint8_t Col, uint32_t Num, uint8_t Size)
 {
@@ -0,0 +1,175 @@
+#include "PROFILE.h"
+#include "stdio.h"
+#include "string.h"
+
+#ifdef PROFILE_HOST
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#else
+#include "usart.h"
+#endif
+
+static const char *const prof_site_name[PROF_SITE_NUM] = {
+    "LINE_PID",
+    "STEER_UPDATE",
+    "MPU_READ",
+    "USART_FRAME",
+    "OLED_STRING",
+    "LINE_CAPTURE",
+};
+
+static PROF_STAT_T prof_stat[PROF_SITE_NUM];
+static uint32_t prof_ticks_per_us = 1;
+
+#ifdef PROFILE_HOST
+static uint64_t Profile_Host_Ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+uint32_t Profile_Now(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return (uint32_t)__rdtsc();
+#else
+    return (uint32_t)Profile_Host_Ns();
+#endif
+}
+#endif
+
+/**
+ * @brief 开启计数器并清空统计
+ */
+void Profile_Init(void)
+{
+#ifdef PROFILE_HOST
+#if defined(__x86_64__) || defined(__i386__)
+    // 用 10ms 的 clock_gettime 标定 TSC 频率
+    uint64_t ns0 = Profile_Host_Ns();
+    uint64_t tsc0 = __rdtsc();
+    while (Profile_Host_Ns() - ns0 < 10000000ull);
+    prof_ticks_per_us = (uint32_t)((__rdtsc() - tsc0) / ((Profile_Host_Ns() - ns0) / 1000ull));
+#else
+    prof_ticks_per_us = 1000;
+#endif
+#else
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    prof_ticks_per_us = SystemCoreClock / 1000000U;
+#endif
+    if (prof_ticks_per_us == 0) prof_ticks_per_us = 1;
+    Profile_Reset();
+}
+
+void Profile_Reset(void)
+{
+    memset(prof_stat, 0, sizeof(prof_stat));
+    for (uint8_t i = 0; i < PROF_SITE_NUM; i++)
+    {
+        prof_stat[i].min = 0xFFFFFFFFu;
+    }
+}
+
+static uint8_t Profile_Bin(uint32_t ticks)
+{
+    uint8_t bin;
+    if (ticks == 0) return 0;
+#ifdef PROFILE_HOST
+    bin = (uint8_t)(31 - __builtin_clz(ticks));
+#else
+    bin = (uint8_t)(31 - __CLZ(ticks));
+#endif
+    return (bin >= PROF_HIST_BINS) ? (PROF_HIST_BINS - 1) : bin;
+}
+
+/**
+ * @brief 记录一次测量。同一测量点可能被不同任务调用 (如 MPU6050_ReadData)，更新时关中断
+ */
+void Profile_Record(PROF_SITE_E site, uint32_t ticks)
+{
+    PROF_STAT_T *s = &prof_stat[site];
+    uint8_t bin = Profile_Bin(ticks);
+#ifndef PROFILE_HOST
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+#endif
+    s->count++;
+    s->sum += ticks;
+    if (ticks < s->min) s->min = ticks;
+    if (ticks > s->max) s->max = ticks;
+    s->hist[bin]++;
+#ifndef PROFILE_HOST
+    __set_PRIMASK(primask);
+#endif
+}
+
+const PROF_STAT_T *Profile_Get(PROF_SITE_E site)
+{
+    return &prof_stat[site];
+}
+
+uint32_t Profile_Format(char *buf, uint32_t size)
+{
+    uint32_t len = 0;
+    int n;
+
+    for (uint8_t i = 0; i < PROF_SITE_NUM && len < size; i++)
+    {
+        PROF_STAT_T s = prof_stat[i];   // 拷贝一份，避免打印过程中被更新
+        if (s.count == 0) continue;
+
+        uint32_t mean = (uint32_t)(s.sum / s.count);
+        uint32_t mean_cus = (uint32_t)((uint64_t)mean * 100 / prof_ticks_per_us);     // 0.01us
+        uint32_t max_cus = (uint32_t)((uint64_t)s.max * 100 / prof_ticks_per_us);
+        // 1. 统计值: 原始计数 + 换算成 us
+        n = snprintf(buf + len, size - len,
+                     "PROF %-12s n=%lu min=%lu mean=%lu max=%lu ticks, mean=%lu.%02lu max=%lu.%02lu us\r\n",
+                     prof_site_name[i], (unsigned long)s.count, (unsigned long)s.min,
+                     (unsigned long)mean, (unsigned long)s.max,
+                     (unsigned long)(mean_cus / 100), (unsigned long)(mean_cus % 100),
+                     (unsigned long)(max_cus / 100), (unsigned long)(max_cus % 100));
+        if (n < 0 || (uint32_t)n >= size - len) break;
+        len += n;
+
+        // 2. 直方图: 只打印非空桶，格式 2^k:次数
+        n = snprintf(buf + len, size - len, "PROF %-12s hist", prof_site_name[i]);
+        if (n < 0 || (uint32_t)n >= size - len) break;
+        len += n;
+        for (uint8_t b = 0; b < PROF_HIST_BINS; b++)
+        {
+            if (s.hist[b] == 0) continue;
+            n = snprintf(buf + len, size - len, " 2^%u:%lu", b, (unsigned long)s.hist[b]);
+            if (n < 0 || (uint32_t)n >= size - len) break;
+            len += n;
+        }
+        n = snprintf(buf + len, size - len, "\r\n");
+        if (n < 0 || (uint32_t)n >= size - len) break;
+        len += n;
+    }
+    return len;
+}
+
+#ifndef PROFILE_HOST
+void Profile_Report(void)
+{
+    static char report[2048];     // 每个测量点的直方图最多 PROF_HIST_BINS 项
+    static uint32_t last_tick = 0;
+    uint32_t len;
+
+    // 1. 到周期且发送通道空闲才格式化，避免覆盖正在 DMA 发送的缓冲
+    if (HAL_GetTick() - last_tick < PROF_REPORT_PERIOD_MS) return;
+    if (huart2.gState != HAL_UART_STATE_READY) return;
+
+    len = Profile_Format(report, sizeof(report));
+    if (len == 0) return;
+    if (USART_USER_DMA_USART2TX_TRANSMIT((uint8_t *)report, (uint16_t)len) == HAL_OK)
+    {
+        last_tick = HAL_GetTick();
+    }
+}
+#endif
@@ -0,0 +1,77 @@
+#ifndef __PROFILE_H
+#define __PROFILE_H
+
+#include "stdint.h"
+
+/*
+ * 热点路径周期计数
+ * 固件: DWT->CYCCNT (168MHz 下 1 计数 = 1 个 CPU 周期)
+ * 主机 (编译时定义 PROFILE_HOST，供 Tools/line_sim 使用): x86 用 rdtsc，其余平台用 clock_gettime
+ *
+ * 用法:
+ *   PROF_BEGIN(PROF_LINE_PID);
+ *   ... 被测代码 (中间不能 return) ...
+ *   PROF_END(PROF_LINE_PID);
+ * PROFILE_ENABLE 置 0 时宏展开为空，不占用任何周期
+ */
+
+#ifndef PROFILE_ENABLE
+#define PROFILE_ENABLE          1
+#endif
+#define PROF_HIST_BINS          25      // 按 log2(计数) 分桶: 第 k 桶为 [2^k, 2^(k+1))，最后一桶包含更大的值
+                                        // (168MHz 下 2^24 约 100ms，I2C / OLED 等毫秒级测量点也落在各自的桶里)
+#define PROF_REPORT_PERIOD_MS   2000    // Service 任务发送报告的周期
+
+/* 测量点 */
+typedef enum
+{
+    PROF_LINE_PID = 0,      // Line_Tracker_PID_Action 一次正常循迹
+    PROF_STEER_UPDATE,      // Steer_Ctrl_Update
+    PROF_MPU_READ,          // MPU6050_ReadData (I2C 14 字节)
+    PROF_USART_FRAME,       // USART_FrameProcess
+    PROF_OLED_STRING,       // OLED_DispString
+    PROF_LINE_CAPTURE,      // Line_Capture_Reduce 一个控制周期的过采样归约
+    PROF_SITE_NUM
+} PROF_SITE_E;
+
+typedef struct
+{
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t sum;
+    uint32_t hist[PROF_HIST_BINS];
+} PROF_STAT_T;
+
+#ifdef PROFILE_HOST
+uint32_t Profile_Now(void);
+#else
+#include "stm32f4xx.h"
+#define Profile_Now() (DWT->CYCCNT)
+#endif
+
+#if PROFILE_ENABLE
+#define PROF_BEGIN(site)    uint32_t prof_t0_##site = Profile_Now()
+#define PROF_END(site)      Profile_Record((site), Profile_Now() - prof_t0_##site)
+#else
+#define PROF_BEGIN(site)
+#define PROF_END(site)
+#endif
+
+void Profile_Init(void);
+void Profile_Reset(void);
+void Profile_Record(PROF_SITE_E site, uint32_t ticks);
+const PROF_STAT_T *Profile_Get(PROF_SITE_E site);
+/**
+ * @brief 把所有测量点的统计格式化为文本 (每个测量点两行: 统计值 + 直方图)
+ * @return 写入的字节数 (不含结尾 0)
+ */
+uint32_t Profile_Format(char *buf, uint32_t size);
+#ifndef PROFILE_HOST
+/**
+ * @brief 经 USART2 DMA 发送报告 (由 Service 任务调用，与遥测共用发送通道)，非阻塞
+ */
+void Profile_Report(void);
+#endif
+
+#endif // __PROFILE_H
@@ -0,0 +1,214 @@
+#include "RECOVER.h"
+#include "TIMEBASE.h"
+#include "usart.h"
+#include "stdio.h"
+#include "math.h"
+
+#define RECOVER_DEG2RAD     0.017453293f
+#define RECOVER_RAD2DEG     57.29578f
+
+typedef enum
+{
+    RECOVER_PHASE_DIRECT = 0,
+    RECOVER_PHASE_SEARCH
+} RECOVER_PHASE_E;
+
+/* 预期线 */
+typedef struct
+{
+    float x, y;             // 线上一点 (m)
+    float yaw;              // 线方向 (deg)
+    uint8_t valid;
+} RECOVER_LINE_T;
+
+/* 一次找线的过程状态 */
+typedef struct
+{
+    uint8_t phase;          // RECOVER_PHASE_E
+    uint8_t src;            // RECOVER_SRC_E
+    uint8_t crossed;        // 直接找线时已到达预期线
+    int8_t side;            // 当前段的走向: 1 偏左, -1 偏右
+    float leg_len;          // 当前段长度 (m)
+    float leg_dist;         // 当前段起点的累计路程
+    float e0;               // 开始时传感器到预期线的横向距离 (m，在线左侧为正)
+    float cross_dist;       // 到达预期线时的累计路程
+    uint32_t start_us;
+    uint32_t phase_us;
+} RECOVER_RUN_T;
+
+typedef struct
+{
+    uint32_t count;         // 累计找线次数
+    uint32_t duration_ms;   // 开始找线到压线 (或失败) 的时间
+    int16_t e0_cm;
+    uint8_t src;
+    uint8_t phase;          // 结束时所处阶段
+    uint8_t result;         // RECOVER_RESULT_E
+} RECOVER_REPORT_T;
+
+static RECOVER_LINE_T rec_line;
+static RECOVER_RUN_T rec;
+static RECOVER_REPORT_T rec_report;
+static volatile uint8_t rec_report_pending = 0;
+
+static float Recover_Wrap(float deg)
+{
+    while (deg >= 180.0f) deg -= 360.0f;
+    while (deg < -180.0f) deg += 360.0f;
+    return deg;
+}
+
+/**
+ * @brief 传感器到预期线的横向距离 (在线左侧为正)
+ */
+static float Recover_Cross(const ODOM_POSE_T *pose)
+{
+    float a = pose->yaw * RECOVER_DEG2RAD;
+    float la = rec_line.yaw * RECOVER_DEG2RAD;
+    float sx = pose->x + RECOVER_SENSOR_X_M * cosf(a);
+    float sy = pose->y + RECOVER_SENSOR_X_M * sinf(a);
+
+    return -sinf(la) * (sx - rec_line.x) + cosf(la) * (sy - rec_line.y);
+}
+
+static void Recover_Heading(const ODOM_POSE_T *pose, float target, int speed, int *left, int *right)
+{
+    int turn = (int)(RECOVER_HEADING_KP * Recover_Wrap(target - pose->yaw));
+
+    if (turn > RECOVER_TURN_MAX) turn = RECOVER_TURN_MAX;
+    if (turn < -RECOVER_TURN_MAX) turn = -RECOVER_TURN_MAX;
+    *left = speed - turn;
+    *right = speed + turn;
+}
+
+static void Recover_Finish(RECOVER_RESULT_E result)
+{
+    rec_report.duration_ms = Timebase_Elapsed_Us(rec.start_us) / 1000u;
+    rec_report.e0_cm = (int16_t)(rec.e0 * 100.0f);
+    rec_report.src = rec.src;
+    rec_report.phase = rec.phase;
+    rec_report.result = (uint8_t)result;
+    rec_report.count++;
+    rec_report_pending = 1;
+}
+
+void Recover_Note_Line(const ODOM_POSE_T *pose, float error)
+{
+    float a = pose->yaw * RECOVER_DEG2RAD;
+
+    rec_line.x = pose->x + RECOVER_SENSOR_X_M * cosf(a);
+    rec_line.y = pose->y + RECOVER_SENSOR_X_M * sinf(a);
+    if (!rec_line.valid)
+    {
+        rec_line.yaw = pose->yaw;
+        rec_line.valid = 1;
+    }
+    else if (fabsf(error) <= 1.0f)
+    {
+        rec_line.yaw += RECOVER_HEADING_ALPHA * Recover_Wrap(pose->yaw - rec_line.yaw);
+    }
+}
+
+void Recover_Set_Line(float x, float y, float yaw_deg)
+{
+    rec_line.x = x;
+    rec_line.y = y;
+    rec_line.yaw = yaw_deg;
+    rec_line.valid = 1;
+}
+
+void Recover_Start(RECOVER_SRC_E src, int8_t first_side, const ODOM_POSE_T *pose)
+{
+    // 没有记录过线 (上电后还没压过线): 假设线就在车头方向
+    if (!rec_line.valid)
+    {
+        Recover_Note_Line(pose, 0.0f);
+    }
+    rec.src = (uint8_t)src;
+    rec.phase = RECOVER_PHASE_DIRECT;
+    rec.crossed = 0;
+    rec.leg_len = RECOVER_LEG_START_M;
+    rec.e0 = Recover_Cross(pose);
+    rec.side = first_side ? first_side : ((rec.e0 > 0.0f) ? -1 : 1);
+    rec.start_us = Timebase_Now_Us();
+    rec.phase_us = rec.start_us;
+}
+
+RECOVER_RESULT_E Recover_Step(const ODOM_POSE_T *pose, uint8_t line_seen, int *left, int *right)
+{
+    float e, target;
+
+    *left = 0;
+    *right = 0;
+    if (line_seen)
+    {
+        Recover_Finish(RECOVER_FOUND);
+        return RECOVER_FOUND;
+    }
+    if (Timebase_Elapsed_Us(rec.start_us) > RECOVER_TIMEOUT_MS * 1000u)
+    {
+        Recover_Finish(RECOVER_FAILED);
+        return RECOVER_FAILED;
+    }
+
+    // 1. 直接找线: 线在右侧 (e > 0) 就向右切，距离越近接近角越小，压线时基本与线平行
+    if (rec.phase == RECOVER_PHASE_DIRECT)
+    {
+        e = Recover_Cross(pose);
+        if (!rec.crossed && (fabsf(e) < RECOVER_ON_LINE_M || e * rec.e0 < 0.0f))
+        {
+            rec.crossed = 1;
+            rec.cross_dist = pose->dist;
+        }
+        if ((rec.crossed && pose->dist - rec.cross_dist > RECOVER_DIRECT_M) ||
+            Timebase_Elapsed_Us(rec.phase_us) > RECOVER_DIRECT_MS * 1000u)
+        {
+            rec.phase = RECOVER_PHASE_SEARCH;
+            rec.phase_us = Timebase_Now_Us();
+            rec.leg_dist = pose->dist;
+        }
+        else
+        {
+            target = RECOVER_RAD2DEG * atanf(e / RECOVER_APPROACH_M);
+            if (target > RECOVER_APPROACH_MAX_DEG) target = RECOVER_APPROACH_MAX_DEG;
+            if (target < -RECOVER_APPROACH_MAX_DEG) target = -RECOVER_APPROACH_MAX_DEG;
+            Recover_Heading(pose, rec_line.yaw - target, RECOVER_SPEED, left, right);
+            return RECOVER_RUNNING;
+        }
+    }
+
+    // 2. 扩大搜索: 沿 线方向 + side * RECOVER_SEARCH_DEG 走完一段后换向，下一段加长
+    if (pose->dist - rec.leg_dist >= rec.leg_len)
+    {
+        rec.side = (int8_t)-rec.side;
+        rec.leg_dist = pose->dist;
+        rec.leg_len += RECOVER_LEG_STEP_M;
+        if (rec.leg_len > RECOVER_LEG_MAX_M)
+        {
+            Recover_Finish(RECOVER_FAILED);
+            return RECOVER_FAILED;
+        }
+    }
+    Recover_Heading(pose, rec_line.yaw + (float)rec.side * RECOVER_SEARCH_DEG, RECOVER_SPEED, left, right);
+    return RECOVER_RUNNING;
+}
+
+void Recover_Report(void)
+{
+    static char line[96];
+    int len;
+
+    if (!rec_report_pending) return;
+    if (huart2.gState != HAL_UART_STATE_READY) return;
+
+    len = snprintf(line, sizeof(line), "RECOVER n=%lu src=%s t=%lums phase=%s e0=%dcm %s\r\n",
+                   (unsigned long)rec_report.count, (rec_report.src == RECOVER_SRC_AVOID) ? "avoid" : "lost",
+                   (unsigned long)rec_report.duration_ms,
+                   (rec_report.phase == RECOVER_PHASE_DIRECT) ? "direct" : "search",
+                   rec_report.e0_cm, (rec_report.result == RECOVER_FOUND) ? "ok" : "fail");
+    if (len <= 0) return;
+    if (USART_USER_DMA_USART2TX_TRANSMIT((uint8_t *)line, (uint16_t)len) == HAL_OK)
+    {
+        rec_report_pending = 0;
+    }
+}
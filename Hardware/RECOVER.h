@@ -0,0 +1,78 @@
+#ifndef __RECOVER_H
+#define __RECOVER_H
+
+#include "stdint.h"
+#include "ODOMETRY.h"
+
+/*
+ * 找线
+ * 预期线: 里程计坐标系中过 (x, y)、方向 yaw 的直线。循迹时每拍用传感器位置和平滑后的航向更新 (Recover_Note_Line)，
+ * 避障结束时直接取触发避障时的位姿 (Recover_Set_Line)。
+ * 1. 直接找线: 按传感器到预期线的横向距离取接近角 (距离越大越陡，不超过 RECOVER_APPROACH_MAX_DEG)，
+ *    航向 P 控制开向预期线；横向距离到 0 之后又走了 RECOVER_DIRECT_M 仍未压线 (预期线不准) 或超时 -> 2
+ * 2. 扩大搜索: 沿预期线方向 ± RECOVER_SEARCH_DEG 走之字形，每段比上一段长 RECOVER_LEG_STEP_M，
+ *    横向覆盖范围逐段扩大，同时向前推进 (线的方向偏了也会被斜着穿过)；先走向线更可能在的一侧，
+ *    段长超过 RECOVER_LEG_MAX_M 或总时间超时则失败停车
+ * 任一传感器压线即找回。每次找线结束后由服务任务发送一行 "RECOVER ..." 报告找回耗时。
+ */
+
+#ifndef RECOVER_ENABLE
+#define RECOVER_ENABLE              1
+#endif
+#define RECOVER_SENSOR_X_M          0.08f   // 循迹传感器在里程计原点 (两轮中点) 前方的距离
+#define RECOVER_HEADING_ALPHA       0.05f   // 线方向低通系数 (只在误差小、车与线平行时更新)
+#define RECOVER_SPEED               20      // 找线的 PWM
+#define RECOVER_HEADING_KP          0.8f    // 航向误差 (deg) -> 差速 PWM
+#define RECOVER_TURN_MAX            20
+#define RECOVER_APPROACH_M          0.10f   // 接近角 = atan(横向距离 / 该值)
+#define RECOVER_APPROACH_MAX_DEG    60.0f
+#define RECOVER_ON_LINE_M           0.02f   // 横向距离小于该值视为已到预期线
+#define RECOVER_DIRECT_M            0.20f   // 到预期线之后再走这么远仍未压线转入搜索
+#define RECOVER_DIRECT_MS           2000u   // 直接找线的超时
+#define RECOVER_SEARCH_DEG          45.0f   // 之字形各段与预期线的夹角
+#define RECOVER_LEG_START_M         0.10f   // 第一段长度 (从预期线出发，只走半幅)
+#define RECOVER_LEG_STEP_M          0.10f   // 每段加长
+#define RECOVER_LEG_MAX_M           0.50f   // 横向覆盖约 ±(LEG_MAX / 2) * sin(SEARCH_DEG)
+#define RECOVER_TIMEOUT_MS          10000u  // 总超时
+
+/* 找线的起因 */
+typedef enum
+{
+    RECOVER_SRC_LOST = 0,       // 循迹中丢线
+    RECOVER_SRC_AVOID           // 绕行结束时未压线
+} RECOVER_SRC_E;
+
+/* Recover_Step 返回值 */
+typedef enum
+{
+    RECOVER_RUNNING = 0,
+    RECOVER_FOUND,
+    RECOVER_FAILED
+} RECOVER_RESULT_E;
+
+/**
+ * @brief 在线上时每拍调用，更新预期线
+ * @param error 循迹误差，|error| 小 (车与线平行) 时才更新线方向
+ */
+void Recover_Note_Line(const ODOM_POSE_T *pose, float error);
+/**
+ * @brief 直接指定预期线 (避障结束时用触发避障时的位姿)
+ */
+void Recover_Set_Line(float x, float y, float yaw_deg);
+/**
+ * @brief 开始找线
+ * @param first_side 搜索先摆向的一侧: 1 左, -1 右, 0 按预期线所在一侧
+ */
+void Recover_Start(RECOVER_SRC_E src, int8_t first_side, const ODOM_POSE_T *pose);
+/**
+ * @brief 找线推进一步，每个控制周期调用
+ * @param line_seen 本周期任一传感器压线
+ * @param left / right 输出轮速 (RUNNING 时有效，FAILED 时为 0)
+ */
+RECOVER_RESULT_E Recover_Step(const ODOM_POSE_T *pose, uint8_t line_seen, int *left, int *right);
+/**
+ * @brief 发送最近一次找线的结果 (文本行，以 "RECOVER" 开头)，由服务任务周期调用
+ */
+void Recover_Report(void);
+
+#endif // __RECOVER_H
@@ -0,0 +1,154 @@
+#include "SCAN.h"
+#include "SG90.h"
+#include "Avoid.h"
+#include "TIMEBASE.h"
+#include "GRID.h"
+#include "math.h"
+#include "stdlib.h"
+
+#define SCAN_DEG2RAD    0.017453293f
+#define SCAN_BAND_M     0.10f   // 前沿之前这么远内的回波也算该障碍物 (波束宽、测距误差)
+#define SCAN_FAR_M      9.99f   // 无回波时回波点取在波束方向的这个距离上
+
+static SCAN_POINT_T scan_buf[SCAN_BUF_SIZE];
+static uint32_t scan_head = 0;      // 下一个写入位置
+static uint8_t scan_index = 0;      // 本次扫描已测的点数
+static int16_t scan_angle = 0;      // 当前命令的相对角度 (左为正)
+static uint32_t scan_cmd_us = 0;    // 舵机命令时刻
+static uint32_t scan_wait_us = 0;   // 本次转动加稳定需要的时间
+static uint8_t scan_pinging = 0;    // 当前角度已发出 Trig，等回波
+
+/**
+ * @brief 舵机转到相对车头的角度，并按转过的角度估计到位时间
+ */
+static void Scan_Servo(int16_t angle)
+{
+    int16_t deg = SCAN_CENTER_DEG + SCAN_SERVO_DIR * angle;
+    int16_t move = (angle > scan_angle) ? (angle - scan_angle) : (scan_angle - angle);
+
+    if (deg < 0) deg = 0;
+    if (deg > 180) deg = 180;
+    SG90_Config(SCAN_SERVO, (uint8_t)deg);
+    scan_wait_us = ((uint32_t)move * SCAN_MS_PER_DEG + SCAN_SETTLE_MS) * 1000u;
+    scan_cmd_us = Timebase_Now_Us();
+    scan_angle = angle;
+}
+
+void Scan_Begin(void)
+{
+    // 触发避障时超声波朝正前方
+    scan_index = 0;
+    scan_angle = 0;
+    scan_pinging = 0;
+    Scan_Servo(SCAN_ARC_DEG / 2);
+}
+
+uint8_t Scan_Step(const ODOM_POSE_T *pose)
+{
+    SCAN_POINT_T *pt;
+    float r, a;
+
+    if (scan_index >= SCAN_POINTS) return 1;
+    if (Timebase_Elapsed_Us(scan_cmd_us) < scan_wait_us) return 0;
+
+    // 1. 舵机到位后发出 Trig，之后每个周期查询一次，回波结束 (无回波时约 35ms) 前不等待
+    if (!scan_pinging)
+    {
+        HCSR04_Trigger();
+        scan_pinging = 1;
+        return 0;
+    }
+    if (!HCSR04_Poll(&r)) return 0;
+    scan_pinging = 0;
+
+    // 2. 按当前位姿换算成回波点
+    pt = &scan_buf[scan_head & (SCAN_BUF_SIZE - 1)];
+    pt->angle = (int8_t)scan_angle;
+    pt->range_cm = (uint16_t)r;
+    pt->time_us = HCSR04_Get_Last_Time_Us();
+    // 占据栅格在里程计坐标系，用里程计位姿写入 (pose 可能是调用者的局部坐标)
+    Grid_Insert(Odom_Get(), (float)scan_angle, r, pt->time_us);
+    r = (r >= 999.0f) ? SCAN_FAR_M : r * 0.01f;
+    a = (pose->yaw + (float)scan_angle) * SCAN_DEG2RAD;
+    pt->px = pose->x + r * cosf(a);
+    pt->py = pose->y + r * sinf(a);
+    scan_head++;
+    scan_index++;
+
+    // 3. 从左往右扫，扫完回中
+    if (scan_index < SCAN_POINTS)
+    {
+        Scan_Servo(scan_angle - SCAN_STEP_DEG);
+        return 0;
+    }
+    Scan_Servo(0);
+    return 1;
+}
+
+void Scan_Analyze(float obst_x, float depth, float clear_w, SCAN_RESULT_T *res)
+{
+    const SCAN_POINT_T *pts[SCAN_POINTS];
+    uint8_t center = 0;
+    int16_t i;
+
+    res->points = 0;
+    res->front_x = obst_x;
+    if (scan_index < SCAN_POINTS) return;
+
+    // 1. 最近一次扫描的点，写入顺序即从左到右；正前方的点为中心
+    for (i = 0; i < SCAN_POINTS; i++)
+    {
+        pts[i] = &scan_buf[(scan_head - SCAN_POINTS + i) & (SCAN_BUF_SIZE - 1)];
+        if (abs(pts[i]->angle) < abs(pts[center]->angle)) center = (uint8_t)i;
+    }
+    res->points = SCAN_POINTS;
+
+    // 2. 从中心分别向左 (side 0)、向右 (side 1) 走:
+    //    连续落在障碍物纵深范围内的回波属于障碍物，其中最靠外的即边缘；
+    //    边缘之外，通道 (横向 edge ~ edge + clear_w，纵向到障碍物后沿) 内还有回波则该侧受阻
+    for (uint8_t side = 0; side < 2; side++)
+    {
+        float sgn = (side == 0) ? 1.0f : -1.0f;
+        int16_t step = (side == 0) ? -1 : 1;
+        uint8_t in_obst = 1;
+        float edge = 0.0f;
+        float edge_r = 0.0f;
+
+        res->blocked[side] = 0;
+        res->open_end[side] = 1;
+        for (i = center; i >= 0 && i < SCAN_POINTS; i += step)
+        {
+            const SCAN_POINT_T *p = pts[i];
+            uint8_t echo = (p->range_cm < 999);
+            float lat = sgn * p->py;
+
+            if (in_obst)
+            {
+                if (echo && p->px >= obst_x - SCAN_BAND_M && p->px <= obst_x + depth)
+                {
+                    if (lat > edge || edge_r == 0.0f)
+                    {
+                        edge = lat;
+                        edge_r = p->range_cm * 0.01f;
+                    }
+                    if (p->px < res->front_x) res->front_x = p->px;
+                    continue;
+                }
+                // 真实边缘在最后一个回波和第一个无回波方向之间，按半个角度间隔向外补
+                in_obst = 0;
+                res->open_end[side] = 0;
+                edge += edge_r * sinf(0.5f * SCAN_STEP_DEG * SCAN_DEG2RAD);
+            }
+            if (echo && p->px <= obst_x + depth + SCAN_BAND_M && lat > edge && lat < edge + clear_w)
+            {
+                res->blocked[side] = 1;
+            }
+        }
+        res->edge[side] = (edge > 0.0f) ? edge : 0.0f;
+    }
+}
+
+const SCAN_POINT_T *Scan_Get_Point(uint8_t age)
+{
+    return &scan_buf[(scan_head - 1u - age) & (SCAN_BUF_SIZE - 1)];
+}
@@ -0,0 +1,68 @@
+#ifndef __SCAN_H
+#define __SCAN_H
+
+#include "stdint.h"
+#include "ODOMETRY.h"
+
+/*
+ * 舵机扫描测距
+ * HC-SR04 装在 SG901 舵机上，避障开始时在减速过程中左右扫一遍，每个角度的测距连同当时的位姿
+ * 换算成调用者位姿所在坐标系下的回波点，写入环形缓冲 (极坐标剖面)，同时写入占据栅格 (GRID.c)。
+ * Scan_Analyze 由最近一次扫描找出障碍物左右边缘以及两侧是否还有其他障碍物，供绕行规划选择绕行方向和横向偏移。
+ * 扫描中途每个控制周期调用一次 Scan_Step，不阻塞: 舵机转动和等回波 (HCSR04_Trigger / HCSR04_Poll，
+ * Echo 边沿由外部中断记录) 期间照常控制电机。
+ */
+
+#ifndef SCAN_ENABLE
+#define SCAN_ENABLE             1
+#endif
+#define SCAN_SERVO              SG901   // 装超声波的舵机
+#define SCAN_CENTER_DEG         90      // 舵机朝正前方的角度
+#define SCAN_SERVO_DIR          1       // 舵机角度增大时超声波向左转；反之改为 -1
+#define SCAN_ARC_DEG            120     // 扫描范围 (以正前方为中心)
+#define SCAN_STEP_DEG           15      // 相邻测距点的角度间隔
+#define SCAN_MS_PER_DEG         2       // 舵机转速 (SG90 空载约 0.1s/60°) 加余量
+#define SCAN_SETTLE_MS          10      // 到位后等抖动衰减再测距
+#define SCAN_BUF_SIZE           32      // 环形缓冲点数，必须为 2 的幂，不小于一次扫描的点数
+#define SCAN_POINTS             (SCAN_ARC_DEG / SCAN_STEP_DEG + 1)
+
+/* 一个测距点 */
+typedef struct
+{
+    int8_t angle;           // 相对车头的角度 (deg，左为正)
+    uint16_t range_cm;      // 999 为无回波
+    float px;               // 回波点 (与 Scan_Step 传入的位姿同一坐标系，m)，无回波时沿波束取 9.99m 处
+    float py;
+    uint32_t time_us;       // 测距时刻 (TIMEBASE 微秒)
+} SCAN_POINT_T;
+
+/* 一次扫描的分析结果 */
+typedef struct
+{
+    uint8_t points;         // 参与分析的点数，0 表示扫描无效
+    uint8_t blocked[2];     // [0] 左 [1] 右: 边缘外侧通道内还有其他回波
+    uint8_t open_end[2];    // 回波一直延续到扫描范围尽头，没看到边缘
+    float edge[2];          // 障碍物朝该侧的边缘到 y = 0 的距离 (m，不带方向)
+    float front_x;          // 障碍物前沿 (最近的障碍物回波点 x)
+} SCAN_RESULT_T;
+
+/**
+ * @brief 开始一次扫描: 舵机先转到扫描范围的一端
+ */
+void Scan_Begin(void);
+/**
+ * @brief 扫描推进一步，每个控制周期调用；舵机到位时测距并记录，然后转向下一个角度
+ * @param pose 当前位姿，用于把测距换算成回波点
+ * @return 1: 扫描完成，舵机已命令回中
+ */
+uint8_t Scan_Step(const ODOM_POSE_T *pose);
+/**
+ * @brief 分析最近一次扫描
+ * @param obst_x 触发时测得的障碍物前沿 x，前后 depth 范围内的回波视为该障碍物
+ * @param depth 障碍物纵深
+ * @param clear_w 车通过所需的横向宽度，边缘外侧这么宽的通道内有回波即判定该侧受阻
+ */
+void Scan_Analyze(float obst_x, float depth, float clear_w, SCAN_RESULT_T *res);
+const SCAN_POINT_T *Scan_Get_Point(uint8_t age);
+
+#endif // __SCAN_H
@@ -0,0 +1,146 @@
+#include "STEER_CTRL.h"
+#include "math.h"
+
+#define STEER_PI 3.14159265f
+
+/**
+ * @brief 按基础速度在增益表中线性插值，超出两端时取端点值；空表时增益全为 0 (输出 0)
+ */
+static void Steer_Lookup_Gain(const STEER_CFG_T *cfg, float speed, STEER_GAIN_T *gain)
+{
+    static const STEER_GAIN_T zero_gain = { 0 };
+    const STEER_GAIN_T *tab = cfg->schedule;
+    uint8_t n = cfg->schedule_len;
+
+    if (n == 0 || tab == 0)
+    {
+        *gain = zero_gain;
+        return;
+    }
+    if (speed <= tab[0].speed)
+    {
+        *gain = tab[0];
+        return;
+    }
+    for (uint8_t i = 1; i < n; i++)
+    {
+        if (speed <= tab[i].speed)
+        {
+            float t = (speed - tab[i - 1].speed) / (tab[i].speed - tab[i - 1].speed);
+            gain->speed = speed;
+            gain->kp  = tab[i - 1].kp  + t * (tab[i].kp  - tab[i - 1].kp);
+            gain->ki  = tab[i - 1].ki  + t * (tab[i].ki  - tab[i - 1].ki);
+            gain->kd  = tab[i - 1].kd  + t * (tab[i].kd  - tab[i - 1].kd);
+            gain->kff = tab[i - 1].kff + t * (tab[i].kff - tab[i - 1].kff);
+            gain->kpv = tab[i - 1].kpv + t * (tab[i].kpv - tab[i - 1].kpv);
+            return;
+        }
+    }
+    *gain = tab[n - 1];
+}
+
+static float Steer_Lowpass(float *state, float input, float cutoff_hz, float dt)
+{
+    if (cutoff_hz <= 0.0f)
+    {
+        *state = input;
+    }
+    else
+    {
+        float tau = 1.0f / (2.0f * STEER_PI * cutoff_hz);
+        *state += (dt / (tau + dt)) * (input - *state);
+    }
+    return *state;
+}
+
+static float Steer_Clamp(float x, float limit)
+{
+    if (x > limit) return limit;
+    if (x < -limit) return -limit;
+    return x;
+}
+
+void Steer_Ctrl_Init(STEER_CTRL_T *ctrl, const STEER_CFG_T *cfg)
+{
+    ctrl->cfg = cfg;
+    Steer_Ctrl_Reset(ctrl);
+}
+
+/**
+ * @brief 清除历史 (路口盲转、避障结束后调用)
+ */
+void Steer_Ctrl_Reset(STEER_CTRL_T *ctrl)
+{
+    ctrl->last_error = 0;
+    ctrl->d_filt = 0;
+    ctrl->yaw_filt = 0;
+    ctrl->integral = 0;
+    ctrl->p_term = 0;
+    ctrl->d_term = 0;
+    ctrl->ff_term = 0;
+    ctrl->preview = 0;
+    ctrl->pv_term = 0;
+    ctrl->output = 0;
+    ctrl->primed = 0;
+}
+
+void Steer_Ctrl_Set_Preview(STEER_CTRL_T *ctrl, float preview)
+{
+    ctrl->preview = preview;
+}
+
+float Steer_Ctrl_Update(STEER_CTRL_T *ctrl, float error, float base_speed, float yaw_rate_dps, float dt)
+{
+    const STEER_CFG_T *cfg = ctrl->cfg;
+    STEER_GAIN_T gain;
+
+    // 1. 原 PD：与旧 Line_Tracker_PID_Action 的计算逐拍一致
+    if (cfg->mode == STEER_MODE_PD)
+    {
+        if (cfg->schedule_len == 0 || cfg->schedule == 0)
+        {
+            ctrl->output = 0.0f;
+            return ctrl->output;
+        }
+        ctrl->p_term = error * cfg->schedule[0].kp;
+        ctrl->d_term = (error - ctrl->last_error) * cfg->schedule[0].kd;
+        ctrl->last_error = error;
+        ctrl->output = ctrl->p_term + ctrl->d_term;
+        return ctrl->output;
+    }
+
+    if (dt <= 0.0f) dt = 0.001f;
+    Steer_Lookup_Gain(cfg, base_speed, &gain);
+
+    // 2. 比例
+    ctrl->p_term = gain.kp * error;
+
+    // 3. 微分：对误差求导后一阶低通，首拍不求导防止跳变
+    if (ctrl->primed)
+    {
+        Steer_Lowpass(&ctrl->d_filt, (error - ctrl->last_error) / dt, cfg->d_cutoff_hz, dt);
+    }
+    ctrl->primed = 1;
+    ctrl->last_error = error;
+    ctrl->d_term = gain.kd * ctrl->d_filt;
+
+    // 4. 横摆角速度前馈：陀螺仪正值为左转，车身一开始转动就提前给出反向差速，
+    //    不必等到传感器看到线偏移，相当于对航向加阻尼 (仿真中顺向前馈会发散)
+    ctrl->ff_term = gain.kff * Steer_Lowpass(&ctrl->yaw_filt, yaw_rate_dps, cfg->ff_cutoff_hz, dt);
+
+    // 5. 前视前馈：前方弯道在车体下的传感器看到偏差之前就开始转向
+    ctrl->pv_term = gain.kpv * ctrl->preview;
+
+    // 6. 积分：限幅 + 积分分离，输出饱和且同向时不再累加
+    float unsat = ctrl->p_term + ctrl->integral + ctrl->d_term + ctrl->ff_term + ctrl->pv_term;
+    uint8_t saturated = (fabsf(unsat) >= cfg->out_limit) && ((unsat > 0) == (error > 0));
+    if (fabsf(error) < cfg->i_zone && !saturated)
+    {
+        ctrl->integral += gain.ki * error * dt;
+        ctrl->integral = Steer_Clamp(ctrl->integral, cfg->i_limit);
+    }
+
+    ctrl->output = Steer_Clamp(ctrl->p_term + ctrl->integral + ctrl->d_term + ctrl->ff_term + ctrl->pv_term,
+                               cfg->out_limit);
+    return ctrl->output;
+}
@@ -0,0 +1,76 @@
+#ifndef __STEER_CTRL_H
+#define __STEER_CTRL_H
+
+#include "stdint.h"
+
+/*
+ * 循迹转向控制器
+ * 不依赖 HAL / RTOS，固件与主机仿真 (Tools/line_sim) 共用同一份实现
+ */
+
+/* 控制器类型 */
+typedef enum
+{
+    STEER_MODE_PD = 0,          // 原固定增益 PD (离散差分，不除 dt)
+    STEER_MODE_SCHEDULED = 1    // 增益调度 PID + 微分滤波 + 横摆角速度前馈
+} STEER_MODE_E;
+
+/* 增益调度表的一个断点 (按基础速度从小到大排列) */
+typedef struct
+{
+    float speed;    // 基础速度断点 (PWM 百分比)
+    float kp;       // 比例增益 [输出/误差]
+    float ki;       // 积分增益 [输出/(误差*s)]
+    float kd;       // 微分增益 [输出*s/误差]
+    float kff;      // 横摆角速度前馈增益 [输出/(deg/s)]
+    float kpv;      // 前视前馈增益 [输出/误差]，前视量由调用者给出 (Steer_Ctrl_Set_Preview)
+} STEER_GAIN_T;
+
+/* 控制器配置 (一般放在 const 区) */
+typedef struct
+{
+    STEER_MODE_E mode;
+    const STEER_GAIN_T *schedule;   // 增益表，PD 模式只使用第 0 项的 kp/kd
+    uint8_t schedule_len;
+    float d_cutoff_hz;              // 微分项一阶低通截止频率，<=0 表示不滤波
+    float ff_cutoff_hz;             // 前馈角速度低通截止频率，只保留弯道的稳态转弯率
+    float i_limit;                  // 积分项限幅 (输出单位)
+    float i_zone;                   // |误差| 小于此值才积分，丢线(±4)时冻结积分
+    float out_limit;                // 总输出限幅
+} STEER_CFG_T;
+
+/* 控制器运行状态 */
+typedef struct
+{
+    const STEER_CFG_T *cfg;
+    float last_error;
+    float d_filt;       // 滤波后的误差变化率 [误差/s]
+    float yaw_filt;     // 滤波后的横摆角速度 [deg/s]
+    float integral;     // 积分项 (已乘 ki，直接是输出单位)
+    float p_term;
+    float d_term;
+    float ff_term;
+    float preview;      // 前视量 (误差单位，正数: 前方线在右侧)，0 表示没有
+    float pv_term;
+    float output;
+    uint8_t primed;     // 0: 首拍，不计算微分
+} STEER_CTRL_T;
+
+void Steer_Ctrl_Init(STEER_CTRL_T *ctrl, const STEER_CFG_T *cfg);
+void Steer_Ctrl_Reset(STEER_CTRL_T *ctrl);
+/**
+ * @brief 设置前视量 (如摄像头看到的前方线位置 / 弯曲)，在 Steer_Ctrl_Update 之前调用，保持到下次设置
+ * @param preview 误差单位，正数: 前方线在右侧；没有前视数据时传 0
+ */
+void Steer_Ctrl_Set_Preview(STEER_CTRL_T *ctrl, float preview);
+/**
+ * @brief 计算一拍转向输出
+ * @param error        循迹误差 (正数: 线在右侧)
+ * @param base_speed   当前基础速度，用于查增益表
+ * @param yaw_rate_dps 陀螺仪 Z 轴角速度 (正数: 左转)，无 IMU 时传 0
+ * @param dt           距上次调用的时间 (s)
+ * @return 差速输出 (正数: 左轮加速/右轮减速，即右转)
+ */
+float Steer_Ctrl_Update(STEER_CTRL_T *ctrl, float error, float base_speed, float yaw_rate_dps, float dt);
+
+#endif // __STEER_CTRL_H
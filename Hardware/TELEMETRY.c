@@ -0,0 +1,183 @@
+#include "TELEMETRY.h"
+#include "usart.h"
+
+/* 编译期检查记录长度 (Keil ARMCC5 不支持 _Static_assert) */
+typedef char tlm_record_size_check[(sizeof(TLM_RECORD_T) == 32) ? 1 : -1];
+typedef char tlm_task_size_check[(sizeof(TLM_TASK_T) == 32) ? 1 : -1];
+typedef char tlm_sys_size_check[(sizeof(TLM_SYS_T) == 32) ? 1 : -1];
+typedef char tlm_panic_size_check[(sizeof(TLM_PANIC_T) == 32) ? 1 : -1];
+
+/* 单生产者 / 单消费者环形缓冲 */
+typedef struct
+{
+    TLM_SLOT_T *buf;
+    uint32_t size;              // 2 的幂
+    uint32_t guard;             // 生产者与正在 DMA 发送的记录之间保留的余量
+    volatile uint32_t head;     // 只由生产者修改
+    uint32_t tail;              // 只由消费者修改
+    uint32_t dropped;
+} TLM_RING_T;
+
+static TLM_SLOT_T tlm_tick_buf[TLM_RING_SIZE];
+static TLM_SLOT_T tlm_svc_buf[TLM_SVC_RING_SIZE];
+static TLM_RING_T tlm_tick = { tlm_tick_buf, TLM_RING_SIZE, TLM_GUARD, 0, 0, 0 };
+static TLM_RING_T tlm_svc = { tlm_svc_buf, TLM_SVC_RING_SIZE, TLM_SVC_GUARD, 0, 0, 0 };
+static volatile uint8_t tlm_state = TLM_STATE_TRACK;
+
+/**
+ * @brief 前 31 字节按字节异或。按字读取后折叠，约十几条指令
+ */
+static uint8_t Telemetry_Checksum(const void *rec)
+{
+    const uint32_t *w = (const uint32_t *)rec;
+    uint32_t x = w[0] ^ w[1] ^ w[2] ^ w[3] ^ w[4] ^ w[5] ^ w[6] ^ (w[7] & 0x00FFFFFFu);
+    x ^= x >> 16;
+    x ^= x >> 8;
+    return (uint8_t)x;
+}
+
+/**
+ * @brief 填写记录头和校验，记录写完后才发布写指针，消费者看到的一定是完整记录
+ */
+static void Telemetry_Ring_Commit(TLM_RING_T *ring, TLM_SLOT_T *slot, uint8_t type)
+{
+    uint32_t head = ring->head;
+
+    slot->tick.sync = TLM_SYNC;
+    slot->tick.type = type;
+    slot->tick.seq = (uint16_t)head;
+    slot->tick.time = HAL_GetTick();
+    slot->tick.checksum = Telemetry_Checksum(slot);
+
+    __DMB();
+    ring->head = head + 1;
+}
+
+/**
+ * @brief 取一段物理连续的记录直接交给 DMA，不做拷贝
+ * @return 1: 已启动 DMA
+ */
+static uint8_t Telemetry_Ring_Drain(TLM_RING_T *ring)
+{
+    uint32_t head = ring->head;
+    uint32_t count;
+    uint32_t idx;
+
+    // 1. 积压过多：丢弃最旧的记录，保证正在发送的记录不会被生产者追上覆盖
+    if (head - ring->tail > ring->size - ring->guard)
+    {
+        ring->dropped += head - ring->tail - (ring->size - ring->guard);
+        ring->tail = head - (ring->size - ring->guard);
+    }
+
+    count = head - ring->tail;
+    if (count == 0) return 0;
+    idx = ring->tail & (ring->size - 1);
+    if (count > ring->size - idx) count = ring->size - idx;
+    if (count > TLM_DRAIN_MAX) count = TLM_DRAIN_MAX;
+
+    if (USART_USER_DMA_USART2TX_TRANSMIT((uint8_t *)&ring->buf[idx], (uint16_t)(count * sizeof(TLM_SLOT_T))) != HAL_OK)
+    {
+        return 0;
+    }
+    ring->tail += count;
+    return 1;
+}
+
+void Telemetry_Init(void)
+{
+    tlm_tick.head = tlm_tick.tail = tlm_tick.dropped = 0;
+    tlm_svc.head = tlm_svc.tail = tlm_svc.dropped = 0;
+    tlm_state = TLM_STATE_TRACK;
+}
+
+void Telemetry_Set_State(TLM_STATE_E state)
+{
+    tlm_state = (uint8_t)state;
+}
+
+TLM_RECORD_T *Telemetry_Begin(void)
+{
+    return &tlm_tick.buf[tlm_tick.head & (TLM_RING_SIZE - 1)].tick;
+}
+
+void Telemetry_Commit(TLM_RECORD_T *rec)
+{
+    rec->state = tlm_state;
+    Telemetry_Ring_Commit(&tlm_tick, (TLM_SLOT_T *)rec, TLM_TYPE_TICK);
+}
+
+TLM_SLOT_T *Telemetry_Service_Begin(void)
+{
+    return &tlm_svc.buf[tlm_svc.head & (TLM_SVC_RING_SIZE - 1)];
+}
+
+void Telemetry_Service_Commit(TLM_SLOT_T *slot, uint8_t type)
+{
+    Telemetry_Ring_Commit(&tlm_svc, slot, type);
+}
+
+void Telemetry_Drain(void)
+{
+#if TLM_STREAM_ENABLE
+    // 上一次 DMA 未完成 (或串口正被占用) 则下次再发
+    if (huart2.gState != HAL_UART_STATE_READY) return;
+
+    // 服务记录量小，优先发送
+    if (Telemetry_Ring_Drain(&tlm_svc)) return;
+    Telemetry_Ring_Drain(&tlm_tick);
+#endif
+}
+
+static void Telemetry_Putc_Poll(uint8_t c)
+{
+    while ((SERIAL_USART->SR & USART_SR_TXE) == 0);
+    SERIAL_USART->DR = c;
+}
+
+static void Telemetry_Write_Poll(const void *data, uint32_t size)
+{
+    const uint8_t *p = (const uint8_t *)data;
+    while (size--) Telemetry_Putc_Poll(*p++);
+}
+
+void Telemetry_Panic_Dump(uint8_t reason)
+{
+    TLM_PANIC_T panic;
+    uint32_t head = tlm_tick.head;
+    uint32_t n = (head < TLM_PANIC_RECORDS) ? head : TLM_PANIC_RECORDS;
+
+    // 1. 停掉 DMA 发送，改为寄存器轮询 (此时不能依赖中断和 RTOS)
+    CLEAR_BIT(SERIAL_USART->CR3, USART_CR3_DMAT);
+    if (hdma_usart2_tx.Instance != NULL)
+    {
+        __HAL_DMA_DISABLE(&hdma_usart2_tx);
+    }
+
+    // 2. 现场记录
+    panic.sync = TLM_SYNC;
+    panic.type = TLM_TYPE_PANIC;
+    panic.seq = (uint16_t)(head - 1);
+    panic.time = HAL_GetTick();
+    panic.cfsr = SCB->CFSR;
+    panic.hfsr = SCB->HFSR;
+    panic.mmfar = SCB->MMFAR;
+    panic.bfar = SCB->BFAR;
+    panic.head = head;
+    panic.reason = reason;
+    panic.reserved[0] = panic.reserved[1] = 0;
+    panic.checksum = Telemetry_Checksum(&panic);
+    Telemetry_Write_Poll(&panic, sizeof(panic));
+
+    // 3. 按时间顺序发出最近 n 条记录
+    for (uint32_t i = head - n; i != head; i++)
+    {
+        Telemetry_Write_Poll(&tlm_tick.buf[i & (TLM_RING_SIZE - 1)], sizeof(TLM_SLOT_T));
+    }
+    while ((SERIAL_USART->SR & USART_SR_TC) == 0);
+}
+
+uint32_t Telemetry_Get_Dropped(void)
+{
+    return tlm_tick.dropped + tlm_svc.dropped;
+}
@@ -0,0 +1,156 @@
+#ifndef __TELEMETRY_H
+#define __TELEMETRY_H
+
+#include "main.h"
+
+/*
+ * 飞行记录仪：每个控制周期写一条 32 字节定长记录到 RAM 环形缓冲
+ * 单生产者 (循迹任务) / 单消费者 (Service 任务，DMA 发送)，无锁
+ * 另有一个小的服务环形缓冲，供运行监控写低频记录 (同样单生产者)
+ * HardFault 时以寄存器轮询方式把最近的记录倒出来
+ * 主机端解码: Tools/tlm_decode.py
+ */
+
+#define TLM_STREAM_ENABLE   1       // 1: 后台经 USART2 发送; 0: 只在 RAM 中记录
+                                    // USART2 TX 即 K230 的 RX: K230 UART.py parse_command 只接受单独的 "0" / "1"，
+                                    // 遥测记录和 PROF / AVOID 等文本行被丢弃；与记录粘在同一行的指令也会被丢弃
+#define TLM_SYNC            0xA5
+#define TLM_RING_SIZE       256     // 记录条数，必须为 2 的幂 (256 * 32B = 8KB，10ms 周期约 2.5s)
+#define TLM_DRAIN_MAX       16      // 每次 DMA 最多发送的记录条数 (512B，115200 下约 45ms)
+#define TLM_DRAIN_PERIOD_MS 50      // Service 任务调用 Telemetry_Drain 的周期
+#define TLM_GUARD           32      // 生产者与正在 DMA 发送的记录之间保留的余量
+#define TLM_SVC_RING_SIZE   32      // 服务记录条数，必须为 2 的幂
+#define TLM_SVC_GUARD       16      // 不小于运行监控一次写入的记录数
+#define TLM_PANIC_RECORDS   64      // 崩溃时倒出的最近记录条数
+
+/* 记录类型 */
+#define TLM_TYPE_TICK       0x01    // 控制周期记录
+#define TLM_TYPE_TASK       0x10    // 任务统计 (MONITOR.c)
+#define TLM_TYPE_SYS        0x11    // 堆/队列统计 (MONITOR.c)
+#define TLM_TYPE_PANIC      0xEE    // 崩溃现场 (之后紧跟最近的 TICK 记录)
+
+/* 崩溃原因 */
+#define TLM_PANIC_HARDFAULT     1
+#define TLM_PANIC_STACK         2   // vApplicationStackOverflowHook
+#define TLM_PANIC_MALLOC        3   // vApplicationMallocFailedHook
+
+/* 状态机状态 */
+typedef enum
+{
+    TLM_STATE_TRACK = 0,        // 正常循迹
+    TLM_STATE_JUNCTION,         // 路口停车，等待视觉指令
+    TLM_STATE_BLIND_TURN,       // 路口盲转
+    TLM_STATE_AVOID,            // 避障流程
+    TLM_STATE_RECOVER           // 丢线后找线
+} TLM_STATE_E;
+
+/* 控制周期记录，全部字段自然对齐，无需 packed (小端) */
+typedef struct
+{
+    uint8_t  sync;          // TLM_SYNC
+    uint8_t  type;          // TLM_TYPE_TICK
+    uint16_t seq;           // 序号，主机据此统计丢包
+    uint32_t time;          // 时间戳 (ms)
+    int16_t  error;         // 循迹误差 x100
+    int16_t  output;        // 转向输出 x10
+    int8_t   left;          // 左轮指令 (死区补偿后)
+    int8_t   right;         // 右轮指令
+    uint8_t  sensor;        // 传感器状态 L2 L1 R1 R2 -> bit3..bit0
+    uint8_t  state;         // TLM_STATE_E
+    int16_t  yaw_rate;      // Z 轴角速度 x10 (deg/s，正数左转)
+    uint16_t distance;      // 超声波距离 (mm)，0xFFFF 表示超时
+    int16_t  p_term;        // 转向各分量 x10
+    int16_t  i_term;
+    int16_t  d_term;
+    int16_t  ff_term;
+    uint16_t latency_us;    // 传感器采样到电机指令写入的延迟 (us)，饱和到 65535
+    int8_t   pv_term;       // 摄像头前视前馈分量 (整数，饱和到 ±127)
+    uint8_t  checksum;      // 前 31 字节异或
+} TLM_RECORD_T;
+
+/* 任务统计记录，每个任务一条 */
+typedef struct
+{
+    uint8_t  sync;
+    uint8_t  type;          // TLM_TYPE_TASK
+    uint16_t seq;
+    uint32_t time;
+    char     name[10];      // 任务名前 10 个字符 (不足补 0)
+    uint16_t cpu;           // 上个统计周期的 CPU 占用 (0.1%)
+    uint16_t stack_free;    // 栈历史最小剩余 (字)
+    uint8_t  priority;      // FreeRTOS 优先级数值
+    uint8_t  state;         // eTaskState
+    uint8_t  number;        // xTaskNumber
+    uint8_t  flags;         // MON_FLAG_*
+    uint8_t  reserved[5];
+    uint8_t  checksum;
+} TLM_TASK_T;
+
+/* 系统统计记录 */
+typedef struct
+{
+    uint8_t  sync;
+    uint8_t  type;          // TLM_TYPE_SYS
+    uint16_t seq;
+    uint32_t time;
+    uint32_t heap_free;     // xPortGetFreeHeapSize
+    uint32_t heap_min;      // xPortGetMinimumEverFreeHeapSize
+    uint16_t idle;          // 空闲任务占用 (0.1%)
+    uint8_t  task_count;
+    uint8_t  stack_warn;    // 栈余量低于阈值的任务数
+    uint8_t  queue_used[4]; // SG90Queue MVQueue MotorQueue OLEDQueue 当前消息数
+    uint8_t  queue_size[4]; // 对应容量
+    uint8_t  reserved[3];
+    uint8_t  checksum;
+} TLM_SYS_T;
+
+/* 崩溃现场记录，与 TLM_RECORD_T 同样 32 字节 */
+typedef struct
+{
+    uint8_t  sync;
+    uint8_t  type;          // TLM_TYPE_PANIC
+    uint16_t seq;           // 最后一条已写入记录的序号
+    uint32_t time;
+    uint32_t cfsr;          // SCB->CFSR
+    uint32_t hfsr;          // SCB->HFSR
+    uint32_t mmfar;
+    uint32_t bfar;
+    uint32_t head;          // 环形缓冲写指针
+    uint8_t  reason;        // TLM_PANIC_*
+    uint8_t  reserved[2];
+    uint8_t  checksum;
+} TLM_PANIC_T;
+
+/* 环形缓冲中的一个槽位 */
+typedef union
+{
+    TLM_RECORD_T tick;
+    TLM_TASK_T   task;
+    TLM_SYS_T    sys;
+} TLM_SLOT_T;
+
+void Telemetry_Init(void);
+void Telemetry_Set_State(TLM_STATE_E state);
+/**
+ * @brief 取得下一条记录的存储位置，调用者直接填写数据字段后调用 Telemetry_Commit
+ *        (sync/type/seq/time/state/checksum 由 Commit 填写)
+ */
+TLM_RECORD_T *Telemetry_Begin(void);
+void Telemetry_Commit(TLM_RECORD_T *rec);
+/**
+ * @brief 服务记录 (任务/系统统计)，用法同 Telemetry_Begin/Commit，只能由一个任务调用
+ */
+TLM_SLOT_T *Telemetry_Service_Begin(void);
+void Telemetry_Service_Commit(TLM_SLOT_T *slot, uint8_t type);
+/**
+ * @brief 后台发送：若 USART2 发送空闲则用 DMA 发出一段连续记录 (服务记录优先)，非阻塞
+ */
+void Telemetry_Drain(void);
+/**
+ * @brief 崩溃时调用：关闭 DMA 发送，以轮询方式发出现场记录和最近 TLM_PANIC_RECORDS 条记录
+ * @param reason TLM_PANIC_*
+ */
+void Telemetry_Panic_Dump(uint8_t reason);
+uint32_t Telemetry_Get_Dropped(void);
+
+#endif // __TELEMETRY_H
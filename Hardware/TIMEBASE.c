@@ -0,0 +1,19 @@
+#include "TIMEBASE.h"
+#include "main.h"
+
+extern TIM_HandleTypeDef htim5;
+
+void Timebase_Init(void)
+{
+    // 已在计数则保持原值，避免已经打好的时间戳失效
+    if ((TIM5->CR1 & TIM_CR1_CEN) == 0)
+    {
+        HAL_TIM_Base_Start(&htim5);
+    }
+}
+
+void Timebase_Delay_Us(uint32_t us)
+{
+    uint32_t t0 = Timebase_Now_Us();
+    while (Timebase_Elapsed_Us(t0) < us);
+}
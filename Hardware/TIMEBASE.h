@@ -0,0 +1,34 @@
+#ifndef __TIMEBASE_H
+#define __TIMEBASE_H
+
+#include "stdint.h"
+#include "stm32f4xx.h"
+
+/*
+ * 微秒时基
+ * TIM5: 32 位向上计数，APB1 定时器时钟 84MHz / 84 = 1MHz，自由运行，约 71.6 分钟回绕一次
+ * 同一个计数器也是 FreeRTOS 运行时间统计的时钟 (freertos.c)
+ *
+ * 各驱动在数据产生的时刻打时间戳，控制代码用时间戳之差算 dt 和端到端延迟:
+ *   循迹传感器采样 / 超声波回波 / MPU6050 采样 / USART2 帧到达 / 电机指令下发
+ * 时间差一律用 uint32_t 无符号相减，回绕自动正确 (间隔小于 71 分钟即可)
+ * 单段代码的周期级耗时用 DWT->CYCCNT (PROFILE.h)，不用这里
+ */
+
+#define TIMEBASE_HZ             1000000u
+
+/* 当前时间 (us)，任务和中断中都可调用 */
+#define Timebase_Now_Us()       (TIM5->CNT)
+/* 从 since 到现在经过的时间 (us) */
+#define Timebase_Elapsed_Us(since)  ((uint32_t)(TIM5->CNT - (uint32_t)(since)))
+
+/**
+ * @brief 启动 TIM5 计数。可重复调用 (main 和 FreeRTOS 运行时间统计都会调用)，已启动时不清零
+ */
+void Timebase_Init(void);
+/**
+ * @brief 忙等延时，不让出 CPU，只用于几十 us 以内的时序 (如超声波 Trig 脉冲)
+ */
+void Timebase_Delay_Us(uint32_t us);
+
+#endif // __TIMEBASE_H
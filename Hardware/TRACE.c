@@ -0,0 +1,217 @@
+#include "TRACE.h"
+#include "main.h"
+#include "queue.h"
+#include "string.h"
+
+/* 编译期检查 (Keil ARMCC5 不支持 _Static_assert) */
+typedef char trace_event_size_check[(sizeof(TRACE_EVENT_T) == 8) ? 1 : -1];
+typedef char trace_hdr_size_check[(sizeof(TRACE_HDR_T) == 16) ? 1 : -1];
+typedef char trace_name_size_check[(sizeof(TRACE_NAME_T) == 16) ? 1 : -1];
+
+#define TRACE_MAX_TASKS     16
+#define TRACE_MAX_NAMES     (TRACE_MAX_TASKS + 16)
+#define TRACE_SEG_NUM       4       // 导出分段: 头和名称表 / 事件 (环形缓冲回绕时分两段) / 尾
+
+extern osMessageQueueId_t SG90QueueHandle;
+extern osMessageQueueId_t MVQueueHandle;
+extern osMessageQueueId_t MotorQueueHandle;
+extern osMessageQueueId_t OLEDQueueHandle;
+
+typedef enum
+{
+    TRACE_IDLE = 0,         // 未初始化，不记录
+    TRACE_RUN,              // 循环覆盖记录
+    TRACE_TRIGGERED,        // 已触发，再记 trace_post 条后冻结
+    TRACE_FROZEN,           // 等待导出
+    TRACE_DUMP              // 正在导出
+} TRACE_STATE_E;
+
+typedef struct
+{
+    uint8_t id;
+    const char *name;
+} TRACE_ID_NAME_T;
+
+/* 队列编号从 1 开始，0 表示未编号的队列 (信号量、互斥量等)，不记录 */
+static const TRACE_ID_NAME_T trace_isr_name[] = {
+    { USART2_IRQn,          "USART2" },
+    { DMA1_Stream5_IRQn,    "DMA1_S5 RX" },
+    { DMA1_Stream6_IRQn,    "DMA1_S6 TX" },
+    { TIM1_UP_TIM10_IRQn,   "TIM1 HAL tick" },
+};
+static const TRACE_ID_NAME_T trace_mark_name[] = {
+    { TRACE_MARK_CTRL_TICK, "CTRL_TICK" },
+};
+static const char *const trace_queue_name[] = { "SG90Queue", "MVQueue", "MotorQueue", "OLEDQueue" };
+
+static TRACE_EVENT_T trace_buf[TRACE_BUF_SIZE];
+static volatile uint32_t trace_head = 0;
+static volatile uint8_t trace_state = TRACE_IDLE;
+static uint16_t trace_post = 0;
+static uint8_t trace_cause = 0;
+
+/* 导出用数据 */
+static struct
+{
+    TRACE_HDR_T  hdr;
+    TRACE_NAME_T name[TRACE_MAX_NAMES];
+} trace_meta;
+static TRACE_TAIL_T trace_tail;
+static TaskStatus_t trace_task_status[TRACE_MAX_TASKS];
+static const uint8_t *trace_seg_ptr[TRACE_SEG_NUM];
+static uint16_t trace_seg_len[TRACE_SEG_NUM];
+static uint8_t trace_seg_idx = 0;
+
+void Trace_Init(void)
+{
+    vQueueSetQueueNumber((QueueHandle_t)SG90QueueHandle, 1);
+    vQueueSetQueueNumber((QueueHandle_t)MVQueueHandle, 2);
+    vQueueSetQueueNumber((QueueHandle_t)MotorQueueHandle, 3);
+    vQueueSetQueueNumber((QueueHandle_t)OLEDQueueHandle, 4);
+
+    // 时间戳用 DWT 周期计数 (Profile_Init 也会开启，这里不清零，不影响耗时统计)
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    trace_head = 0;
+#if TRACE_ENABLE
+    trace_state = TRACE_RUN;
+#endif
+}
+
+void Trace_Event(uint8_t type, uint8_t id, uint16_t arg)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (trace_state == TRACE_RUN || trace_state == TRACE_TRIGGERED)
+    {
+        TRACE_EVENT_T *e = &trace_buf[trace_head & (TRACE_BUF_SIZE - 1)];
+        e->time = DWT->CYCCNT;
+        e->type = type;
+        e->id = id;
+        e->arg = arg;
+        trace_head++;
+        if (trace_state == TRACE_TRIGGERED && --trace_post == 0)
+        {
+            trace_state = TRACE_FROZEN;
+        }
+    }
+    __set_PRIMASK(primask);
+}
+
+void Trace_Queue(uint8_t type, uint32_t number, uint32_t waiting)
+{
+    if (number == 0) return;
+    Trace_Event(type, (uint8_t)number, (uint16_t)waiting);
+}
+
+void Trace_Trigger(uint8_t cause)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (trace_state == TRACE_RUN)
+    {
+        Trace_Event(TRACE_EV_TRIGGER, cause, 0);
+        trace_cause = cause;
+        trace_post = TRACE_POST_TRIGGER;
+        trace_state = TRACE_TRIGGERED;
+    }
+    __set_PRIMASK(primask);
+}
+
+static void Trace_Set_Name(TRACE_NAME_T *entry, uint8_t kind, uint8_t id, const char *name)
+{
+    entry->kind = kind;
+    entry->id = id;
+    strncpy(entry->name, name, sizeof(entry->name));
+}
+
+/**
+ * @brief 缓冲冻结后准备导出: 填写头、名称表和尾，划分 DMA 分段
+ */
+static void Trace_Prepare(void)
+{
+    uint32_t head = trace_head;
+    uint32_t count = (head < TRACE_BUF_SIZE) ? head : TRACE_BUF_SIZE;
+    uint32_t idx = (head - count) & (TRACE_BUF_SIZE - 1);
+    uint32_t first = (count < TRACE_BUF_SIZE - idx) ? count : (TRACE_BUF_SIZE - idx);
+    uint8_t n = 0;
+    uint32_t sum = 0;
+    uint32_t i;
+
+    // 1. 名称表: 任务编号即 uxTCBNumber (xTaskNumber)，与 trace 宏记录的一致
+    UBaseType_t tasks = uxTaskGetSystemState(trace_task_status, TRACE_MAX_TASKS, NULL);
+    for (i = 0; i < tasks; i++)
+    {
+        Trace_Set_Name(&trace_meta.name[n++], TRACE_NAME_TASK,
+                       (uint8_t)trace_task_status[i].xTaskNumber, trace_task_status[i].pcTaskName);
+    }
+    for (i = 0; i < sizeof(trace_queue_name) / sizeof(trace_queue_name[0]); i++)
+    {
+        Trace_Set_Name(&trace_meta.name[n++], TRACE_NAME_QUEUE, (uint8_t)(i + 1), trace_queue_name[i]);
+    }
+    for (i = 0; i < sizeof(trace_isr_name) / sizeof(trace_isr_name[0]); i++)
+    {
+        Trace_Set_Name(&trace_meta.name[n++], TRACE_NAME_ISR, trace_isr_name[i].id, trace_isr_name[i].name);
+    }
+    for (i = 0; i < sizeof(trace_mark_name) / sizeof(trace_mark_name[0]); i++)
+    {
+        Trace_Set_Name(&trace_meta.name[n++], TRACE_NAME_MARK, trace_mark_name[i].id, trace_mark_name[i].name);
+    }
+
+    // 2. 头
+    memcpy(trace_meta.hdr.magic, "TRC1", 4);
+    trace_meta.hdr.count = (uint16_t)count;
+    trace_meta.hdr.name_count = n;
+    trace_meta.hdr.cause = trace_cause;
+    trace_meta.hdr.cpu_hz = SystemCoreClock;
+    trace_meta.hdr.dropped = head - count;
+
+    // 3. 尾: 事件按字累加，主机据此判断数据是否完整
+    for (i = 0; i < count; i++)
+    {
+        const uint32_t *w = (const uint32_t *)&trace_buf[(idx + i) & (TRACE_BUF_SIZE - 1)];
+        sum += w[0] + w[1];
+    }
+    memcpy(trace_tail.magic, "TRCE", 4);
+    trace_tail.sum = sum;
+
+    // 4. 分段，事件直接从缓冲 DMA 发出，不做拷贝
+    trace_seg_ptr[0] = (const uint8_t *)&trace_meta;
+    trace_seg_len[0] = (uint16_t)(sizeof(TRACE_HDR_T) + n * sizeof(TRACE_NAME_T));
+    trace_seg_ptr[1] = (const uint8_t *)&trace_buf[idx];
+    trace_seg_len[1] = (uint16_t)(first * sizeof(TRACE_EVENT_T));
+    trace_seg_ptr[2] = (const uint8_t *)&trace_buf[0];
+    trace_seg_len[2] = (uint16_t)((count - first) * sizeof(TRACE_EVENT_T));
+    trace_seg_ptr[3] = (const uint8_t *)&trace_tail;
+    trace_seg_len[3] = sizeof(TRACE_TAIL_T);
+    trace_seg_idx = 0;
+}
+
+uint8_t Trace_Drain(void)
+{
+    if (trace_state != TRACE_FROZEN && trace_state != TRACE_DUMP) return 0;
+    // 上一段 (或遥测/耗时报告) 还在发送
+    if (huart2.gState != HAL_UART_STATE_READY) return 1;
+
+    if (trace_state == TRACE_FROZEN)
+    {
+        Trace_Prepare();
+        trace_state = TRACE_DUMP;
+    }
+
+    while (trace_seg_idx < TRACE_SEG_NUM && trace_seg_len[trace_seg_idx] == 0) trace_seg_idx++;
+    if (trace_seg_idx == TRACE_SEG_NUM)
+    {
+        // 全部发完 (最后一段的 DMA 也已结束)，重新开始记录，等待下一次触发
+        trace_head = 0;
+        trace_state = TRACE_RUN;
+        return 0;
+    }
+
+    if (USART_USER_DMA_USART2TX_TRANSMIT((uint8_t *)trace_seg_ptr[trace_seg_idx], trace_seg_len[trace_seg_idx]) == HAL_OK)
+    {
+        trace_seg_idx++;
+    }
+    return 1;
+}
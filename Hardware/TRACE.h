@@ -0,0 +1,116 @@
+#ifndef __TRACE_H
+#define __TRACE_H
+
+#include "stdint.h"
+
+/*
+ * 调度事件跟踪
+ * FreeRTOS trace 宏 (FreeRTOSConfig.h USER CODE Defines)、中断入口/出口和消息队列操作
+ * 写入 8 字节定长事件的环形缓冲，时间戳为 DWT->CYCCNT
+ *
+ * 事件量远超串口带宽 (每秒数千次任务切换)，因此不做实时发送，而是快照方式:
+ *   平时循环覆盖 -> Trace_Trigger() 后再记录 TRACE_POST_TRIGGER 条即冻结
+ *   -> Service 任务调用 Trace_Drain() 经 USART2 DMA 整块发出 -> 发完自动重新开始记录
+ * 主机端分析: Tools/trace_timeline.py (时间线、每个任务的最坏响应时间)
+ *
+ * 本头文件会被 FreeRTOSConfig.h 包含，不能依赖 HAL / RTOS 头文件
+ */
+
+#ifndef TRACE_ENABLE
+#define TRACE_ENABLE            1
+#endif
+#define TRACE_BUF_SIZE          1024    // 事件条数，必须为 2 的幂 (1024 * 8B = 8KB)
+#define TRACE_POST_TRIGGER      256     // 触发后继续记录的事件数，其余为触发前的历史
+#define TRACE_LATE_TICK_MS      20      // 循迹控制周期超过该值即触发 (正常约 10ms)
+
+/* 事件类型 */
+#define TRACE_EV_TASK_IN        0x01    // id: 任务编号 (uxTCBNumber)
+#define TRACE_EV_TASK_OUT       0x02
+#define TRACE_EV_TASK_READY     0x03    // 任务进入就绪态 (延时到期 / 等到事件)
+#define TRACE_EV_ISR_ENTER      0x10    // id: IRQn
+#define TRACE_EV_ISR_EXIT       0x11
+#define TRACE_EV_QUEUE_SEND     0x20    // id: 队列编号 (Trace_Init 分配)，arg: 发送前队列中的消息数
+#define TRACE_EV_QUEUE_RECV     0x21
+#define TRACE_EV_QUEUE_BLOCK    0x22    // 队列为空，接收方阻塞
+#define TRACE_EV_QUEUE_FULL     0x23    // 队列已满，发送失败
+#define TRACE_EV_MARK           0x30    // id: TRACE_MARK_*
+#define TRACE_EV_TRIGGER        0xF0    // id: TRACE_TRIG_*
+
+/* 用户标记 */
+#define TRACE_MARK_CTRL_TICK    1       // 一次循迹控制周期开始
+
+/* 触发原因 */
+#define TRACE_TRIG_LATE_TICK    1       // 循迹控制周期超时
+#define TRACE_TRIG_MANUAL       2
+
+/* 事件，8 字节 */
+typedef struct
+{
+    uint32_t time;          // DWT->CYCCNT
+    uint8_t  type;          // TRACE_EV_*
+    uint8_t  id;
+    uint16_t arg;
+} TRACE_EVENT_T;
+
+/* 导出数据块: 头 + 名称表 + 事件 + 尾，全部小端 */
+typedef struct
+{
+    char     magic[4];      // "TRC1"
+    uint16_t count;         // 事件数
+    uint8_t  name_count;    // 名称表条数
+    uint8_t  cause;         // TRACE_TRIG_*
+    uint32_t cpu_hz;        // 时间戳频率
+    uint32_t dropped;       // 触发前被覆盖的事件数
+} TRACE_HDR_T;
+
+#define TRACE_NAME_TASK         0
+#define TRACE_NAME_QUEUE        1
+#define TRACE_NAME_ISR          2
+#define TRACE_NAME_MARK         3
+
+typedef struct
+{
+    uint8_t  kind;          // TRACE_NAME_*
+    uint8_t  id;
+    char     name[14];      // 不足补 0
+} TRACE_NAME_T;
+
+typedef struct
+{
+    char     magic[4];      // "TRCE"
+    uint32_t sum;           // 全部事件按 32 位字累加
+} TRACE_TAIL_T;
+
+#if TRACE_ENABLE
+#define TRACE_ISR_ENTER(irq)    Trace_Event(TRACE_EV_ISR_ENTER, (uint8_t)(irq), 0)
+#define TRACE_ISR_EXIT(irq)     Trace_Event(TRACE_EV_ISR_EXIT, (uint8_t)(irq), 0)
+#define TRACE_MARK(mark)        Trace_Event(TRACE_EV_MARK, (mark), 0)
+#else
+#define TRACE_ISR_ENTER(irq)
+#define TRACE_ISR_EXIT(irq)
+#define TRACE_MARK(mark)
+#endif
+
+/**
+ * @brief 给消息队列分配编号并开始记录，在队列创建之后、任务创建之前调用
+ */
+void Trace_Init(void);
+/**
+ * @brief 记录一个事件，任务、中断和调度器中都可调用 (内部短暂关中断)
+ */
+void Trace_Event(uint8_t type, uint8_t id, uint16_t arg);
+/**
+ * @brief 消息队列事件 (FreeRTOSConfig.h 中的 trace 宏调用)，未编号的队列不记录
+ */
+void Trace_Queue(uint8_t type, uint32_t number, uint32_t waiting);
+/**
+ * @brief 触发一次快照：再记录 TRACE_POST_TRIGGER 条事件后冻结缓冲。已触发时忽略
+ */
+void Trace_Trigger(uint8_t cause);
+/**
+ * @brief 由 Service 任务周期调用，缓冲冻结后经 USART2 DMA 分段发出，非阻塞
+ * @return 1: 正在导出，调用者本周期不要再使用串口发送
+ */
+uint8_t Trace_Drain(void);
+
+#endif // __TRACE_H
@@ -0,0 +1,130 @@
+#include "VISION.h"
+#include "TIMEBASE.h"
+#include "main.h"
+#include "string.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+static VISION_ARROW_T vision_arrow;
+static VISION_COLOR_T vision_color;
+static VISION_LANE_T vision_lane;
+
+static uint8_t Vision_Digit(uint8_t c)
+{
+    return (c >= '0' && c <= '9') ? (uint8_t)(c - '0') : 0xFF;
+}
+
+/**
+ * @brief 解析符号 + 两位十进制 ("+12" / "-05")
+ * @return 1: 成功
+ */
+static uint8_t Vision_Signed(const uint8_t *p, int8_t *out)
+{
+    uint8_t d0 = Vision_Digit(p[1]);
+    uint8_t d1 = Vision_Digit(p[2]);
+
+    if (d0 > 9 || d1 > 9 || (p[0] != '+' && p[0] != '-')) return 0;
+    *out = (int8_t)(d0 * 10 + d1);
+    if (p[0] == '-') *out = (int8_t)-*out;
+    return 1;
+}
+
+uint8_t Vision_Parse_Frame(const uint8_t *frame, uint16_t len, uint32_t time_us)
+{
+    uint8_t cmd, conf, d0, d1, d2;
+
+    // 1. 箭头: "AAAABBB" + 标签 [+ 两位置信度]
+    if (len >= 8 && strncmp((const char *)frame, "AAAABBB", 7) == 0)
+    {
+        switch (frame[7])
+        {
+            case 'L': cmd = 1; break;
+            case 'R': cmd = 2; break;
+            case 'N': cmd = 3; break;
+            default:  return 0;
+        }
+        conf = 100;
+        if (len >= 10)
+        {
+            d0 = Vision_Digit(frame[8]);
+            d1 = Vision_Digit(frame[9]);
+            if (d0 > 9 || d1 > 9) return 0;
+            conf = (uint8_t)(d0 * 10 + d1);
+        }
+        taskENTER_CRITICAL();
+        vision_arrow.cmd = cmd;
+        vision_arrow.conf = conf;
+        vision_arrow.time_us = time_us;
+        vision_arrow.count++;
+        taskEXIT_CRITICAL();
+        return 1;
+    }
+
+    // 2. 颜色: "AABBN" + 三位色块数
+    if (len >= 8 && strncmp((const char *)frame, "AABBN", 5) == 0)
+    {
+        d0 = Vision_Digit(frame[5]);
+        d1 = Vision_Digit(frame[6]);
+        d2 = Vision_Digit(frame[7]);
+        if (d0 > 9 || d1 > 9 || d2 > 9) return 0;
+        taskENTER_CRITICAL();
+        vision_color.blobs[0] = d0;
+        vision_color.blobs[1] = d1;
+        vision_color.blobs[2] = d2;
+        vision_color.time_us = time_us;
+        vision_color.count++;
+        taskEXIT_CRITICAL();
+        return 1;
+    }
+
+    // 3. 车道: "AALN" + 符号两位偏移 + 符号两位弯曲度
+    if (len >= 10 && strncmp((const char *)frame, "AALN", 4) == 0)
+    {
+        int8_t offset, curv;
+
+        if (!Vision_Signed(&frame[4], &offset) || !Vision_Signed(&frame[7], &curv)) return 0;
+        taskENTER_CRITICAL();
+        vision_lane.offset = offset;
+        vision_lane.curv = curv;
+        vision_lane.time_us = time_us;
+        vision_lane.count++;
+        taskEXIT_CRITICAL();
+        return 1;
+    }
+    return 0;
+}
+
+void Vision_Get_Arrow(VISION_ARROW_T *out)
+{
+    taskENTER_CRITICAL();
+    *out = vision_arrow;
+    taskEXIT_CRITICAL();
+}
+
+void Vision_Get_Color(VISION_COLOR_T *out)
+{
+    taskENTER_CRITICAL();
+    *out = vision_color;
+    taskEXIT_CRITICAL();
+}
+
+uint8_t Vision_Get_Lane(uint32_t max_age_ms, VISION_LANE_T *out)
+{
+    taskENTER_CRITICAL();
+    *out = vision_lane;
+    taskEXIT_CRITICAL();
+    if (out->count == 0) return 0;
+    return (Timebase_Elapsed_Us(out->time_us) <= max_age_ms * 1000u);
+}
+
+uint8_t Vision_Get_Turn(uint32_t max_age_ms, uint8_t *cmd)
+{
+    VISION_ARROW_T a;
+
+    Vision_Get_Arrow(&a);
+    if (a.count == 0 || a.cmd == 0) return 0;
+    if (Timebase_Elapsed_Us(a.time_us) > max_age_ms * 1000u) return 0;
+    if (a.conf < VISION_MIN_CONF) return 0;
+    *cmd = a.cmd;
+    return 1;
+}
@@ -0,0 +1,71 @@
+#ifndef __VISION_H
+#define __VISION_H
+
+#include "stdint.h"
+
+/*
+ * K230 视觉结果缓存
+ * K230 连续识别 (流水线模式)，结果变化时以及每隔一段时间主动发送最新结果，
+ * 最近一次推理超过 ARROW_MAX_AGE_MS (UART.py) 时不再发送，到达时刻因此也反映结果本身的时效；
+ * MV 任务收到一帧就解析进缓存并记下到达时刻 (USART2 帧到达时间戳)；
+ * 循迹任务到路口时直接取缓存中足够新的箭头结果，不再等待识别，视觉延迟基本为 0。
+ * 车道几何每帧发送一次，循迹任务取足够新的作为转向前视前馈。
+ * 帧格式 (无校验，按帧头区分):
+ *   "AAAABBB" + L/N/R + 两位置信度 (00~99，旧版脚本不带)   箭头
+ *   "AABBN" + 红 / 绿 / 蓝色块数各一位                      颜色
+ *   "AALN" + 符号两位前视偏移 + 符号两位弯曲度 (如 "AALN+12-05")  车道
+ */
+
+#define VISION_MAX_AGE_MS       500u    // 路口使用缓存结果的最大时效
+#define VISION_MIN_CONF         50      // 路口使用缓存结果的最低置信度 (%)
+#define VISION_WAIT_POLL_MS     20u     // 缓存结果不可用时，路口等待新结果的查询间隔
+
+/* 箭头结果，cmd 与 Execute_Blind_Turn 的指令一致 */
+typedef struct
+{
+    uint8_t cmd;            // 1 左, 2 右, 3 直行 (N)，0 无
+    uint8_t conf;           // 置信度 (%)，旧版脚本不带时取 100
+    uint32_t time_us;       // 到达时刻 (TIMEBASE)
+    uint32_t count;         // 累计收到的箭头帧数
+} VISION_ARROW_T;
+
+/* 颜色结果 */
+typedef struct
+{
+    uint8_t blobs[3];       // 红 / 绿 / 蓝色块数
+    uint32_t time_us;
+    uint32_t count;
+} VISION_COLOR_T;
+
+/* 车道几何 (摄像头前视)，正数: 线在右侧 / 向右弯 */
+typedef struct
+{
+    int8_t offset;          // 前视行上线相对画面中心的横向位置 (半幅画面的 %)
+    int8_t curv;            // 弯曲度: 远 / 中 / 近三行位置的二阶差分 (半幅画面的 %)
+    uint32_t time_us;
+    uint32_t count;
+} VISION_LANE_T;
+
+/**
+ * @brief 解析一帧 K230 数据进缓存，由 MV 任务在 USART_FrameProcess 成功后调用
+ * @param time_us 帧到达时刻 (随帧入队的 _RXBUFF.time_us)
+ * @return 1: 识别出的帧; 0: 未知帧
+ */
+uint8_t Vision_Parse_Frame(const uint8_t *frame, uint16_t len, uint32_t time_us);
+/**
+ * @brief 复制最新的箭头 / 颜色结果 (任意任务可调用)
+ */
+void Vision_Get_Arrow(VISION_ARROW_T *out);
+void Vision_Get_Color(VISION_COLOR_T *out);
+/**
+ * @brief 取时效不超过 max_age_ms 的车道几何
+ * @return 1: out 有效; 0: 没有足够新的数据
+ */
+uint8_t Vision_Get_Lane(uint32_t max_age_ms, VISION_LANE_T *out);
+/**
+ * @brief 取可直接用于路口的转向指令: 时效不超过 max_age_ms 且置信度不低于 VISION_MIN_CONF
+ * @return 1: cmd 有效; 0: 没有可用结果
+ */
+uint8_t Vision_Get_Turn(uint32_t max_age_ms, uint8_t *cmd);
+
+#endif // __VISION_H
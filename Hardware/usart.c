@@ -4,6 +4,7 @@ static _RXBUFF USART2_Rx_Attri;
 static _RXBUFF rxMessage;
 static _RXBUFF  CurrentRxBufStructure;
 static uint8_t MV_CurrentFrame[FRAMESIZE];
+static uint16_t MV_CurrentFrameLen = 0;
 _RXBUFF* pToCurrentRxBufStructure = &CurrentRxBufStructure;				//using for pointing to the rx buffer structure
 uint8_t Global_RxBuffer[USART_BUFFER_SIZE]; 														//global USART buffer
 extern osMessageQueueId_t MVQueueHandle;
@@ -28,14 +29,14 @@ void USART_USER_DMA_USART2RX_START(uint8_t* pToMessageBuffer)
 }
 
 /**
-  * @brief  Activate USART2_RX DMA
+  * @brief  Activate USART2_TX DMA
   * @param  addrOfData	----- Address of buffer
 						size				----- Size of data
-  * @retval None
+  * @retval HAL_OK if the transfer was started, HAL_BUSY if the last one is still running
   */
-void USART_USER_DMA_USART2TX_TRANSMIT(uint8_t* addrOfData, uint16_t size)
+HAL_StatusTypeDef USART_USER_DMA_USART2TX_TRANSMIT(uint8_t* addrOfData, uint16_t size)
 {
-	HAL_UART_Transmit_DMA(&huart2, addrOfData, size);
+	return HAL_UART_Transmit_DMA(&huart2, addrOfData, size);
 }
 
 /**
@@ -57,6 +58,8 @@ void DEBUG_USART_TRANSMIT(uint8_t num)
 void USART2_IDLEInterrup_Handler(void)
 {
 	uint32_t tempNum = 0;
+	//IDLE is raised one character time after the last byte, take it out of the stamp
+	uint32_t time_us = Timebase_Now_Us() - USART2_IDLE_DELAY_US;
 	tempNum = __HAL_DMA_GET_COUNTER(&hdma_usart2_rx);
 	USART2_Rx_Attri.wp = USART_BUFFER_SIZE - tempNum;
 	
@@ -71,6 +74,7 @@ void USART2_IDLEInterrup_Handler(void)
 	rxMessage.wp = USART2_Rx_Attri.wp;
 	rxMessage.len = USART2_Rx_Attri.len;
 	rxMessage.u8 = 0;
+	rxMessage.time_us = time_us;		//queued with the frame, later frames do not overwrite it
 	
 	USART2_Rx_Attri.rp = USART2_Rx_Attri.wp;
 	
@@ -95,6 +99,7 @@ uint8_t USART_FrameProcess(_RXBUFF* pToAttri)
 				return 0;
 			MV_CurrentFrame[j] = Global_RxBuffer[i];	
 		}
+		MV_CurrentFrameLen = j;
 	}
 	
 	//Partition data
@@ -104,13 +109,18 @@ uint8_t USART_FrameProcess(_RXBUFF* pToAttri)
 		uint16_t j = 0;
 		for(; i < USART_BUFFER_SIZE; i++, j++)
 		{
+			if(j >= FRAMESIZE)
+				return 0;
 			MV_CurrentFrame[j] = Global_RxBuffer[i];
 		}
 		
 		for(i = 0; i < pToAttri->wp; i++, j++)
 		{
+			if(j >= FRAMESIZE)
+				return 0;
 			MV_CurrentFrame[j] = Global_RxBuffer[i];
 		}
+		MV_CurrentFrameLen = j;
 	}
 	
 	else
@@ -119,6 +129,17 @@ uint8_t USART_FrameProcess(_RXBUFF* pToAttri)
 	return 1;
 }
 
+/**
+  * @brief  Frame extracted by the last successful USART_FrameProcess
+  * @param  frame	----- Output, pointer to the frame bytes
+  * @retval Length of the frame
+  */
+uint16_t USART_Get_Frame(const uint8_t** frame)
+{
+	*frame = MV_CurrentFrame;
+	return MV_CurrentFrameLen;
+}
+
 /**
   * @brief  Get message from current frame
   * @param  None
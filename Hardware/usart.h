@@ -8,7 +8,8 @@
 #define SERIAL_USART USART2
 #define USART_BUFFER_SIZE 500
 #define MAX_FRAME 100
-#define FRAMESIZE 8
+#define FRAMESIZE 10			//longest K230 frame: "AAAABBB" + label + 2-digit confidence
+#define USART2_IDLE_DELAY_US 87		//one character time at 115200 8N1
 
 typedef struct __RXSTRUCTBUFF
 {
@@ -16,7 +17,8 @@ typedef struct __RXSTRUCTBUFF
 	uint16_t wp;			//Tail Pointer
 	uint16_t len;		  //Length
 	uint8_t u8;			  //Not in use
-}_RXBUFF;
+	uint32_t time_us;	//Arrival time of the frame (TIMEBASE us), stamped in the IDLE interrupt
+}_RXBUFF;						//MVQueue message: each frame carries its own arrival time
 
 extern UART_HandleTypeDef huart2;
 extern DMA_HandleTypeDef hdma_usart2_rx;
@@ -25,10 +27,11 @@ extern _RXBUFF* pToCurrentRxBufStructure;
 
 void USART2_Buffer_Init(void);
 void USART_USER_DMA_USART2RX_START(uint8_t* pToMessageBuffer);
-void USART_USER_DMA_USART2TX_TRANSMIT(uint8_t* addrOfData, uint16_t size);
+HAL_StatusTypeDef USART_USER_DMA_USART2TX_TRANSMIT(uint8_t* addrOfData, uint16_t size);
 void DEBUG_USART_TRANSMIT(uint8_t num);
 void USART2_IDLEInterrup_Handler(void);
 uint8_t USART_FrameProcess(_RXBUFF* pToAttri);
+uint16_t USART_Get_Frame(const uint8_t** frame);
 uint8_t USART_VerifyDatafromFrame(_RXBUFF* pToAttri);
 
 #endif
\ No newline at end of file
@@ -8,6 +8,7 @@ from media.media import *
 import nncase_runtime as nn
 import ulab.numpy as np
 import time,image,random,gc
+import _thread
 
 # -----------------
 # 识别初始化
@@ -46,6 +47,117 @@ roi_x = (DISPLAY_WIDTH - roi_w) // 2
 roi_y = (DISPLAY_HEIGHT - roi_h) // 2
 labels = ["L", "N", "R"]
 
+# -----------------
+# 通道配置
+# 通道0: 显示分辨率 RGB888，直接绑定显示层 (不经 CPU)，ROI 框和识别结果画在 OSD 层；HEADLESS 时不配置、不初始化显示
+# 通道1: AI_WIDTH x AI_HEIGHT 灰度，供箭头识别 (ISP 完成缩放和取亮度，不再裁剪 / 转灰度显示分辨率的 RGB888 大图)
+# 通道2: AI_WIDTH x AI_HEIGHT RGB565，供色块检测
+# ROI 和色块面积阈值按 ai_scale 从显示坐标换算到 AI 通道
+# -----------------
+HEADLESS = False
+AI_WIDTH = 400
+AI_HEIGHT = (DISPLAY_HEIGHT * AI_WIDTH // DISPLAY_WIDTH) & ~1
+ai_scale = AI_WIDTH / DISPLAY_WIDTH
+ai_roi_x, ai_roi_y, ai_roi_w, ai_roi_h = [int(v * ai_scale) for v in (roi_x, roi_y, roi_w, roi_h)]
+BLOB_AREA = int(3000 * ai_scale * ai_scale)
+
+# -----------------
+# 预处理初始化
+# ai2d 硬件从通道1 整帧中裁剪 ROI 并双线性缩放到 64x64，
+# 输出为 convert_k230_ai2d.py 编译时约定的输入: NCHW [1,1,64,64] uint8，归一化 (mean/std 127.5) 在 kmodel 内完成
+# 原 my_resize_togray 逐像素 get_pixel 4096 次，单帧约数百 ms
+# -----------------
+MODEL_W, MODEL_H = 64, 64
+PROFILE_STAGES = True   # 每次识别打印各阶段耗时 (ms)
+
+# -----------------
+# 箭头多帧融合
+# 每帧输出做 softmax 后累加取平均，平均概率最大的类别为结果，其平均概率为置信度 (随结果发给 STM32)
+# 提前结束: 单帧置信度 >= ARROW_CONF_EXIT，或连续两帧结果相同且置信度都 >= ARROW_AGREE_CONF
+# -----------------
+ARROW_MAX_FRAMES = 10
+ARROW_CONF_EXIT = 0.90
+ARROW_AGREE_CONF = 0.60
+
+ai2d = nn.ai2d()
+ai2d.set_dtype(nn.ai2d_format.NCHW_FMT, nn.ai2d_format.NCHW_FMT, np.uint8, np.uint8)
+ai2d.set_crop_param(True, ai_roi_x, ai_roi_y, ai_roi_w, ai_roi_h)
+ai2d.set_resize_param(True, nn.interp_method.tf_bilinear, nn.interp_mode.half_pixel)
+ai2d_builder = ai2d.build([1, 1, AI_HEIGHT, AI_WIDTH], [1, 1, MODEL_H, MODEL_W])
+ai2d_output_np = np.zeros((1, 1, MODEL_H, MODEL_W), dtype=np.uint8)
+ai2d_output_tensor = nn.from_numpy(ai2d_output_np)
+
+# -----------------
+# 箭头定位与跟踪
+# 训练样本中箭头为暗背景上的高亮粗 L 形，约占 64x64 画面的一半且居中。
+# 每帧在通道1 灰度图中找高亮色块 (大小 / 长宽比 / 填充率过滤)，与上一帧的跟踪框就近关联并平滑，
+# 按 SIGN_FILL 扩成正方形裁剪框送入模型，车辆接近路口时即可识别远处任意位置的箭头；
+# 连续 SIGN_LOST_FRAMES 帧找不到时退回画面中央的固定 ROI。
+# 裁剪框边长取 SIGN_SIZES 中不小于所需值的一档，每档预先建好一个 ai2d (边长 -> 64x64)，运行时不重建
+# -----------------
+ARROW_LOCATE = True
+SIGN_GRAY_MIN = 200         # 箭头亮度下限
+SIGN_PIXELS_MIN = 60        # 色块最少像素 (AI 通道)
+SIGN_AREA_MAX = AI_WIDTH * AI_HEIGHT // 4   # 外接框面积上限，排除大片反光 / 亮地面
+SIGN_DENSITY = (0.25, 0.75) # 填充率 (像素 / 外接框面积) 范围，L 形箭头约 0.4
+SIGN_ASPECT_MAX = 2.0       # 外接框长宽比上限
+SIGN_FILL = 0.55            # 箭头外接框占裁剪框边长的比例 (与训练样本一致)
+SIGN_SIZES = (32, 48, 64, 96, 128, 160)
+SIGN_ALPHA = 0.5            # 跟踪框平滑系数 (新观测的权重)
+SIGN_GATE = 0.75            # 关联门限: 中心距离 < SIGN_GATE * 跟踪框边长
+SIGN_LOST_FRAMES = 5
+
+sign_builders = {}
+for size in SIGN_SIZES:
+    b = nn.ai2d()
+    b.set_dtype(nn.ai2d_format.NCHW_FMT, nn.ai2d_format.NCHW_FMT, np.uint8, np.uint8)
+    b.set_resize_param(True, nn.interp_method.tf_bilinear, nn.interp_mode.half_pixel)
+    sign_builders[size] = b.build([1, 1, size, size], [1, 1, MODEL_H, MODEL_W])
+
+# -----------------
+# 流水线模式
+# 采集线程: 取帧 -> 预处理到三缓冲中的后台张量 -> 与"就绪"交换；每 COLOR_EVERY 帧数一次色块
+# 主循环: 取最新就绪张量推理 (与下一帧的采集 / 预处理重叠)，softmax 指数平均后更新结果缓存
+# 结果变化或每隔 STREAM_PERIOD_MS 主动发送最新箭头结果，STM32 缓存后到路口直接使用；
+# 收到 CMD_TURN / CMD_COLOR 立即回复缓存结果，不再现场识别
+# PIPELINE_MODE = False 时为原先的同步请求 / 应答流程
+# -----------------
+PIPELINE_MODE = True
+ARROW_EMA_ALPHA = 0.5       # 新一帧概率的权重
+STREAM_PERIOD_MS = 200      # 结果不变时的重发周期 (STM32 按到达时刻判断结果是否新鲜)
+ARROW_MAX_AGE_MS = 300      # 最近一次推理早于此时不再发送箭头结果 (须小于 STM32 的 VISION_MAX_AGE_MS)，
+                            # 采集停顿时 STM32 的缓存随之过期，CMD_TURN 留到下一次推理后再应答
+COLOR_EVERY = 5             # 每隔多少帧数一次色块
+PROFILE_EVERY = 50          # 每隔多少帧打印一次流水线耗时
+OSD_EVERY = 10              # 结果不变时每隔多少帧刷新一次 OSD
+FRAME_GAP_MS = 2            # 两帧发送的最小间隔 (10 字节约 0.9ms，留出空闲让 STM32 分帧)
+
+# -----------------
+# 车道几何 (流水线模式下每帧一次)
+# 在通道1 灰度图的近 / 中 / 远三条水平带中找黑线色块，质心横坐标归一化到 ±1 (半幅画面)，
+# 前视偏移取最远一条找到的带，弯曲度取三条带位置的二阶差分；以 "AALN+12-05" 发给 STM32 作为转向前馈
+# -----------------
+LANE_ENABLE = True
+LANE_GRAY_MAX = 60                  # 黑线灰度上限
+LANE_ROWS = (0.92, 0.78, 0.64)      # 近 / 中 / 远带中心所在高度 (占画面高度)
+LANE_STRIP_H = 12                   # 带高 (像素)
+LANE_PIXELS_MIN = 30                # 色块最少像素
+LANE_X_SIGN = 1                     # 线在画面右侧为正；摄像头镜像安装时取 -1
+
+pipe_tensors = [nn.from_numpy(np.zeros((1, 1, MODEL_H, MODEL_W), dtype=np.uint8)) for i in range(3)]
+pipe_lock = _thread.allocate_lock()
+pipe_state = {
+    "back": 0, "ready": 1, "front": 2,  # 三缓冲下标: 采集写 back，推理读 front
+    "fresh": False,                     # ready 中是否有未推理的新帧
+    "running": True,
+    "frames": 0,                        # 采集帧数
+    "t_capture": 0,                     # 采集 + 预处理累计耗时 (us)
+    "label": "N", "conf": 0.0,          # 最新箭头结果 (缓存)
+    "color": [0, 0, 0],                 # 最近一次色块计数
+    "ready_track": 0,                   # ready 帧所属的箭头跟踪编号
+    "lane": (0.0, 0.0), "lane_seq": 0,  # 最新车道几何 (前视偏移, 弯曲度) 及其序号
+}
+
 # -----------------
 # 串口初始化
 # -----------------
@@ -69,19 +181,29 @@ data = None
 sensor = Sensor(id=sensor_id)
 # 重置摄像头sensor
 sensor.reset()
-# 设置通道0的输出尺寸
-sensor.set_framesize(width=DISPLAY_WIDTH, height=DISPLAY_HEIGHT, chn=CAM_CHN_ID_0)
-# 设置通道0的输出像素格式为RGB888
-sensor.set_pixformat(Sensor.RGB888, chn=CAM_CHN_ID_0)
-# 根据模式初始化显示器
-if DISPLAY_MODE == "VIRT":
-    Display.init(Display.VIRT, width=DISPLAY_WIDTH, height=DISPLAY_HEIGHT, fps=60)
-elif DISPLAY_MODE == "LCD":
-    Display.init(Display.ST7701, width=DISPLAY_WIDTH, height=DISPLAY_HEIGHT, to_ide=True)
-elif DISPLAY_MODE == "HDMI":
-    Display.init(Display.LT9611, width=DISPLAY_WIDTH, height=DISPLAY_HEIGHT, to_ide=True)
+# 通道1: 识别用灰度小图
+sensor.set_framesize(width=AI_WIDTH, height=AI_HEIGHT, chn=CAM_CHN_ID_1)
+sensor.set_pixformat(Sensor.GRAYSCALE, chn=CAM_CHN_ID_1)
+# 通道2: 色块检测用彩色小图
+sensor.set_framesize(width=AI_WIDTH, height=AI_HEIGHT, chn=CAM_CHN_ID_2)
+sensor.set_pixformat(Sensor.RGB565, chn=CAM_CHN_ID_2)
+if not HEADLESS:
+    # 设置通道0的输出尺寸
+    sensor.set_framesize(width=DISPLAY_WIDTH, height=DISPLAY_HEIGHT, chn=CAM_CHN_ID_0)
+    # 设置通道0的输出像素格式为RGB888
+    sensor.set_pixformat(Sensor.RGB888, chn=CAM_CHN_ID_0)
+    # 通道0 直接绑定到视频层
+    Display.bind_layer(**sensor.bind_info(x=0, y=0, chn=CAM_CHN_ID_0), layer=Display.LAYER_VIDEO1)
+    # 根据模式初始化显示器
+    if DISPLAY_MODE == "VIRT":
+        Display.init(Display.VIRT, width=DISPLAY_WIDTH, height=DISPLAY_HEIGHT, fps=60)
+    elif DISPLAY_MODE == "LCD":
+        Display.init(Display.ST7701, width=DISPLAY_WIDTH, height=DISPLAY_HEIGHT, to_ide=True)
+    elif DISPLAY_MODE == "HDMI":
+        Display.init(Display.LT9611, width=DISPLAY_WIDTH, height=DISPLAY_HEIGHT, to_ide=True)
 # 初始化媒体管理器
 MediaManager.init()
+osd_img = None if HEADLESS else image.Image(DISPLAY_WIDTH, DISPLAY_HEIGHT, image.ARGB8888)
 sensor.set_hmirror(True)
 # 设置垂直翻转
 sensor.set_vflip(True)
@@ -96,6 +218,8 @@ color_threshold_green  = [(0, 100, -78, -9, 5, 27)]
 color_threshold_blue   = [(0, 100, -24, -8, -128, -1)]
 color_threshold_blue_big   = [(25, 41, -24, 23, -42, -12)]
 RGB_blobs_num  =  [0,0,0];
+# 红 / 绿 / 蓝阈值合并为一次 find_blobs，色块的 code() 为 1 << 阈值序号
+color_thresholds = color_threshold_red + color_threshold_green + color_threshold_blue
 
 def update_command():
     data = None
@@ -103,81 +227,363 @@ def update_command():
         data = uart.read()
         #time.sleep_ms(5)
     #uart.write(data)
-    try:
-        # 1. data.decode() 将 bytes (b'1') 转换为 str ('1')
-        # 2. strip() 去除串口发送可能附带的回车换行符 (\r\n)
-        cmd_char = data.decode('utf-8').strip()
-    except Exception:
-        # 如果接收到的数据无法解码（比如干扰数据），返回空字符串
-        cmd_char = ""
-    # --- 修改结束 ---
-
-    return cmd_char
-def my_resize_togray(src_img, dst_w, dst_h):
-        gray_img = src_img
-        gray_img = src_img.to_grayscale()
-
-        src_w = gray_img.width()
-        src_h = gray_img.height()
-        dst_np = np.zeros((dst_h, dst_w), dtype=np.uint8)
-        x_ratio = src_w / dst_w
-        y_ratio = src_h / dst_h
-        for y in range(dst_h):
-            for x in range(dst_w):
-                src_x = int(x * x_ratio)
-                src_y = int(y * y_ratio)
-                pixel_value = gray_img.get_pixel(src_x, src_y)
-                dst_np[y, x] = pixel_value
-        return dst_np
+    # 只取单独的 "0" / "1"，遥测记录和文本报告丢弃 (parse_command)；没有指令返回空字符串
+    cmd_char = parse_command(data)
+    return cmd_char if cmd_char is not None else ""
+def preprocess(img, out_tensor=ai2d_output_tensor):
+    """通道1 灰度帧 -> ai2d 裁剪 ROI 并缩放到模型输入张量 out_tensor"""
+    gray_np = img.to_numpy_ref().reshape((1, 1, AI_HEIGHT, AI_WIDTH))
+    ai2d_builder.run(nn.from_numpy(gray_np), out_tensor)
+    return out_tensor
+
+class SignTracker:
+    """跟踪一个箭头牌: 中心 (cx, cy) 和边长 size 均为 AI 通道坐标，track_id 每次重新捕获时加 1"""
+    def __init__(self):
+        self.cx = self.cy = self.size = 0.0
+        self.misses = SIGN_LOST_FRAMES
+        self.track_id = 0
+        self.box = None     # 当前裁剪框 (x, y, 边长)，None 表示未跟踪
+
+    def candidates(self, img):
+        """高亮色块中形状像箭头的: [(cx, cy, 所需边长), ...]"""
+        out = []
+        for blob in img.find_blobs([(SIGN_GRAY_MIN, 255)], pixels_threshold=SIGN_PIXELS_MIN, merge=True, margin=2):
+            w, h = blob.w(), blob.h()
+            if w * h > SIGN_AREA_MAX or max(w, h) > SIGN_ASPECT_MAX * min(w, h):
+                continue
+            if not (SIGN_DENSITY[0] <= blob.density() <= SIGN_DENSITY[1]):
+                continue
+            out.append((blob.cx(), blob.cy(), max(w, h) / SIGN_FILL))
+        return out
+
+    def update(self, img):
+        """用本帧更新跟踪，返回裁剪框或 None"""
+        best = None
+        best_d = 0
+        for c in self.candidates(img):
+            if self.misses < SIGN_LOST_FRAMES:
+                # 跟踪中: 取门限内离跟踪框最近的
+                d = abs(c[0] - self.cx) + abs(c[1] - self.cy)
+                if d < SIGN_GATE * self.size and (best is None or d < best_d):
+                    best, best_d = c, d
+            elif best is None or c[2] > best[2]:
+                # 未跟踪: 取最大的
+                best = c
+        if best is None:
+            self.misses += 1
+        elif self.misses >= SIGN_LOST_FRAMES:
+            self.cx, self.cy, self.size = best
+            self.misses = 0
+            self.track_id += 1
+        else:
+            self.cx += SIGN_ALPHA * (best[0] - self.cx)
+            self.cy += SIGN_ALPHA * (best[1] - self.cy)
+            self.size += SIGN_ALPHA * (best[2] - self.size)
+            self.misses = 0
+        if self.misses >= SIGN_LOST_FRAMES:
+            self.box = None
+            return None
+        # 边长取不小于所需值的一档，框限制在画面内
+        side = SIGN_SIZES[-1]
+        for size in SIGN_SIZES:
+            if size >= self.size:
+                side = size
+                break
+        side = min(side, AI_HEIGHT)
+        x = min(max(int(self.cx - side / 2), 0), AI_WIDTH - side)
+        y = min(max(int(self.cy - side / 2), 0), AI_HEIGHT - side)
+        self.box = (x, y, side)
+        return self.box
+
+sign_tracker = SignTracker()
+
+def prepare_input(img, out_tensor=ai2d_output_tensor):
+    """定位箭头并预处理到 out_tensor；没有跟踪到箭头时用中央固定 ROI"""
+    box = sign_tracker.update(img) if ARROW_LOCATE else None
+    if box is None or box[2] not in sign_builders:
+        return preprocess(img, out_tensor)
+    x, y, side = box
+    # copy=True: 默认的 crop 会原地裁剪 img，之后的 lane_measure 等还要用整幅画面
+    crop = img.crop(roi=(x, y, side, side), copy=True)
+    sign_builders[side].run(nn.from_numpy(crop.to_numpy_ref().reshape((1, 1, side, side))), out_tensor)
+    del crop
+    return out_tensor
+
+def show_result(text, blobs=()):
+    """在 OSD 层画识别框 (跟踪到的箭头框或中央 ROI)、色块框 (AI 通道坐标) 和结果文字，HEADLESS 时不显示"""
+    if HEADLESS:
+        return
+    osd_img.clear()
+    box = sign_tracker.box
+    if box is None:
+        osd_img.draw_rectangle(roi_x, roi_y, roi_w, roi_h, color=(255, 0, 0), thickness=2)
+    else:
+        side = int(box[2] / ai_scale)
+        osd_img.draw_rectangle(int(box[0] / ai_scale), int(box[1] / ai_scale), side, side, color=(255, 255, 0), thickness=2)
+    for b in blobs:
+        osd_img.draw_rectangle(int(b[0] / ai_scale), int(b[1] / ai_scale), int(b[2] / ai_scale), int(b[3] / ai_scale),
+                               color=(255, 255, 255), thickness=2)
+    osd_img.draw_string_advanced(20, 20, 50, text, color=(0, 255, 0), scale=2)
+    Display.show_image(osd_img, 0, 0, Display.LAYER_OSD0)
+
+def stage_report(name, frames, t_snap, t_pre, t_kpu, t_post):
+    """打印各阶段平均耗时 (us 累计值 -> ms/帧)"""
+    if not PROFILE_STAGES or frames == 0:
+        return
+    print("%s frames=%d snap=%.1fms pre=%.1fms kpu=%.1fms post=%.1fms total=%.1fms" % (
+        name, frames, t_snap / frames / 1000, t_pre / frames / 1000, t_kpu / frames / 1000,
+        t_post / frames / 1000, (t_snap + t_pre + t_kpu + t_post) / 1000))
+
+def softmax(logits):
+    """模型输出 logits -> 概率"""
+    e = np.exp(logits - np.max(logits))
+    return e / np.sum(e)
 
 def arrow_identify():
-    # 捕获通道0的图像
-    result_final = [0,0,0]
-    for jklh in range(10):
-        img = sensor.snapshot(chn=CAM_CHN_ID_0)
-        roi_img = img.crop(roi=(roi_x, roi_y, roi_w, roi_h))
-        # 使用您的函数对ROI区域进行预处理
-        img_np = my_resize_togray(roi_img, 64, 64)
-        del roi_img # 及时释放内存
+    """多帧融合识别箭头，返回 (标签, 置信度 0~1)"""
+    prob_sum = np.zeros(len(labels))
+    last_index = -1
+    last_conf = 0.0
+    frames = 0
+    t_snap = t_pre = t_kpu = t_post = 0
+    while frames < ARROW_MAX_FRAMES:
+        t0 = time.ticks_us()
+        img = sensor.snapshot(chn=CAM_CHN_ID_1)
+        t1 = time.ticks_us()
+        # 定位箭头 + 预处理 (ai2d 缩放)
+        input_tensor = prepare_input(img)
+        t2 = time.ticks_us()
         # AI推理过程
-        runtime_tensor=nn.from_numpy(img_np)
-        kpu.set_input_tensor(0,runtime_tensor)
+        kpu.set_input_tensor(0, input_tensor)
         kpu.run()
-        results=[]
-        for i in range(kpu.outputs_size()):
-            output_i_tensor = kpu.get_output_tensor(i)
-            result_i = output_i_tensor.to_numpy()
-            results.append(result_i)
-            output_i_tensor
-        del runtime_tensor
-        nn.shrink_memory_pool()
-        for i in range(3):
-            result_final[i] = results[0][0][i]
-        img.draw_rectangle(roi_x, roi_y, roi_w, roi_h, color=(255, 0, 0), thickness=2)
-        Display.show_image(img)
+        output_tensor = kpu.get_output_tensor(0)
+        prob = softmax(output_tensor.to_numpy().reshape((len(labels),)))
+        del output_tensor
+        t3 = time.ticks_us()
+        prob_sum += prob
+        frames += 1
+        index = int(np.argmax(prob))
+        conf = float(prob[index])
+        del img
         gc.collect()
-    prediction_index = np.argmax(result_final)
+        t4 = time.ticks_us()
+        t_snap += time.ticks_diff(t1, t0)
+        t_pre += time.ticks_diff(t2, t1)
+        t_kpu += time.ticks_diff(t3, t2)
+        t_post += time.ticks_diff(t4, t3)
+        # 提前结束
+        if conf >= ARROW_CONF_EXIT:
+            break
+        if index == last_index and conf >= ARROW_AGREE_CONF and last_conf >= ARROW_AGREE_CONF:
+            break
+        last_index = index
+        last_conf = conf
+    stage_report("ARROW", frames, t_snap, t_pre, t_kpu, t_post)
+    prob_mean = prob_sum / frames
+    prediction_index = int(np.argmax(prob_mean))
+    confidence = float(prob_mean[prediction_index])
     result_text = labels[prediction_index]
-    img.draw_string_advanced(20, 20, 50, result_text, color=(0, 255, 0), scale=2)
-    return result_text
+    show_result("%s %d%%" % (result_text, int(confidence * 100)))
+    return result_text, confidence
+
+def Find_clors(img):
+    """一帧内按 color_thresholds 一次找出全部色块，返回 ([红, 绿, 蓝] 个数, 色块列表)"""
+    blobs = img.find_blobs(color_thresholds, area_threshold=BLOB_AREA, merge=False)
+    counts = [0, 0, 0]
+    for blob in blobs:
+        for i in range(3):
+            if blob.code() & (1 << i):
+                counts[i] += 1
+    return counts, blobs
 
-def Find_clors(color_threshold):
+def Find_Three_blobs():
     os.exitpoint()
-    img = sensor.snapshot(chn=CAM_CHN_ID_0)
-    blobs = img.find_blobs(color_threshold,area_threshold = 3000)
-    if blobs:
-        for blob in blobs:
-            img.draw_rectangle(blob[0:4])
-            img.draw_cross(blob[5], blob[6])
-            # print("Blob Center: X={}, Y={}".format(blob[5], blob[6]))
-    Display.show_image(img)
-    return len(blobs)
-
-def Find_Three_blobs(threshold_red,threshold_green,threshold_blue):
-    RGB_blobs_num[0] = Find_clors(threshold_red)
-    RGB_blobs_num[1] = Find_clors(threshold_green)
-    RGB_blobs_num[2] = Find_clors(threshold_blue)
-try:
+    img = sensor.snapshot(chn=CAM_CHN_ID_2)
+    counts, blobs = Find_clors(img)
+    del img
+    for i in range(3):
+        RGB_blobs_num[i] = counts[i]
+    show_result("R%d G%d B%d" % tuple(counts), blobs)
+
+def arrow_frame(label, confidence):
+    """箭头结果帧: "AAAABBB" + 标签 + 两位十进制置信度 (00~99)"""
+    return "AAAABBB" + label + "%02d" % min(99, int(confidence * 100))
+
+def color_frame(counts):
+    """颜色结果帧: "AABBN" + 红 / 绿 / 蓝色块数 (各一位)"""
+    return "AABBN" + "".join(str(min(9, n)) for n in counts)
+
+def capture_thread():
+    """流水线采集线程: 取帧、预处理到后台张量，完成后与就绪张量交换；出错时打印并清除 running，主循环随之停止发送"""
+    st = pipe_state
+    try:
+        capture_loop(st)
+    except BaseException as e:
+        print("采集线程异常: ", e)
+    st["running"] = False
+
+def capture_loop(st):
+    while st["running"]:
+        t0 = time.ticks_us()
+        img = sensor.snapshot(chn=CAM_CHN_ID_1)
+        lane = lane_measure(img) if LANE_ENABLE else None
+        prepare_input(img, pipe_tensors[st["back"]])
+        del img
+        with pipe_lock:
+            if lane is not None:
+                st["lane"] = lane
+                st["lane_seq"] += 1
+            st["back"], st["ready"] = st["ready"], st["back"]
+            st["fresh"] = True
+            st["ready_track"] = sign_tracker.track_id
+            st["frames"] += 1
+            st["t_capture"] += time.ticks_diff(time.ticks_us(), t0)
+            frames = st["frames"]
+        if frames % COLOR_EVERY == 0:
+            img = sensor.snapshot(chn=CAM_CHN_ID_2)
+            counts = Find_clors(img)[0]
+            del img
+            with pipe_lock:
+                st["color"] = counts
+
+def lane_measure(img):
+    """三条水平带的黑线质心 -> (前视偏移, 弯曲度)，均为半幅画面的比例；少于两条带找到线时返回 None"""
+    xs = []
+    for row in LANE_ROWS:
+        y = min(max(int(row * AI_HEIGHT) - LANE_STRIP_H // 2, 0), AI_HEIGHT - LANE_STRIP_H)
+        blobs = img.find_blobs([(0, LANE_GRAY_MAX)], roi=(0, y, AI_WIDTH, LANE_STRIP_H),
+                               pixels_threshold=LANE_PIXELS_MIN, merge=True)
+        if not blobs:
+            xs.append(None)
+            continue
+        # 多个候选时取离上一条带最近的 (第一条带取最大的)
+        prev = None
+        for x in xs:
+            if x is not None:
+                prev = x
+        if prev is None:
+            blob = max(blobs, key=lambda b: b.pixels())
+        else:
+            blob = min(blobs, key=lambda b: abs((b.cx() - AI_WIDTH / 2) / (AI_WIDTH / 2) - prev))
+        xs.append(LANE_X_SIGN * (blob.cx() - AI_WIDTH / 2) / (AI_WIDTH / 2))
+    found = [x for x in xs if x is not None]
+    if len(found) < 2:
+        return None
+    curv = (xs[2] - 2 * xs[1] + xs[0]) if len(found) == 3 else 0.0
+    return found[-1], curv
+
+def lane_frame(offset, curv):
+    """车道帧: "AALN" + 符号两位前视偏移 + 符号两位弯曲度 (半幅画面的 %)"""
+    o = max(-99, min(99, int(offset * 100)))
+    c = max(-99, min(99, int(curv * 100)))
+    return "AALN%s%02d%s%02d" % ("-" if o < 0 else "+", abs(o), "-" if c < 0 else "+", abs(c))
+
+def parse_command(data):
+    """
+    从串口数据中取指令: 只认单独成行 (或单独一次读到) 的 "0" / "1"，其余一律丢弃。
+    STM32 的 USART2 TX 同时发送遥测 (0xA5 开头的 32 字节二进制记录) 和 PROF / AVOID / RECOVER 等文本行，
+    整段解码会把它们当成指令或把真正的指令连带丢掉。有多条时取最后一条，没有返回 None
+    """
+    cmd = None
+    # 0xA5 (遥测记录起始) 也作为分隔: 紧跟在指令后面的记录不会连带丢掉指令
+    for seg in data.replace(b"\r", b"\n").replace(b"\xa5", b"\n").split(b"\n"):
+        if seg == b"0" or seg == b"1":
+            cmd = seg.decode()
+    return cmd
+
+def poll_command():
+    """非阻塞读取 STM32 指令，没有返回 None"""
+    data = uart.read()
+    if not data:
+        return None
+    return parse_command(data)
+
+def run_pipeline():
+    """流水线模式主循环: 推理最新帧，维护并发送结果缓存"""
+    st = pipe_state
+    prob_ema = None
+    sent_label = None
+    sent_ms = time.ticks_ms()
+    write_ms = sent_ms
+    infer_ms = sent_ms
+    sent_lane = 0
+    pending_cmd = None
+    inferred = 0
+    t_kpu = 0
+    track = 0
+    _thread.start_new_thread(capture_thread, ())
+    while True:
+        os.exitpoint()
+        if not st["running"]:
+            raise RuntimeError("capture thread stopped")
+        # 1. 取最新就绪帧 (采集线程同时在准备下一帧)
+        with pipe_lock:
+            fresh = st["fresh"]
+            if fresh:
+                st["ready"], st["front"] = st["front"], st["ready"]
+                st["fresh"] = False
+                # 换了一个箭头牌，之前的平均结果作废
+                if st["ready_track"] != track:
+                    track = st["ready_track"]
+                    prob_ema = None
+        if fresh:
+            t0 = time.ticks_us()
+            kpu.set_input_tensor(0, pipe_tensors[st["front"]])
+            kpu.run()
+            output_tensor = kpu.get_output_tensor(0)
+            prob = softmax(output_tensor.to_numpy().reshape((len(labels),)))
+            del output_tensor
+            t_kpu += time.ticks_diff(time.ticks_us(), t0)
+            inferred += 1
+            infer_ms = time.ticks_ms()
+            # 2. 指数平均，更新结果缓存
+            if prob_ema is None:
+                prob_ema = prob
+            else:
+                prob_ema = ARROW_EMA_ALPHA * prob + (1 - ARROW_EMA_ALPHA) * prob_ema
+            index = int(np.argmax(prob_ema))
+            if labels[index] != st["label"] or inferred % OSD_EVERY == 0:
+                show_result("%s %d%%" % (labels[index], int(float(prob_ema[index]) * 100)))
+            st["label"] = labels[index]
+            st["conf"] = float(prob_ema[index])
+            if PROFILE_STAGES and inferred % PROFILE_EVERY == 0:
+                with pipe_lock:
+                    frames = st["frames"]
+                    t_capture = st["t_capture"]
+                print("PIPE frames=%d inferred=%d capture=%.1fms kpu=%.1fms" % (
+                    frames, inferred, t_capture / frames / 1000, t_kpu / inferred / 1000))
+            gc.collect()
+        else:
+            time.sleep_ms(1)
+        # 3. 每拍最多发一帧，两帧至少间隔 FRAME_GAP_MS (STM32 按串口空闲分帧，连发会粘成一帧)
+        #    优先级: 指令应答 > 箭头 (变化 / 定时，仅在最近 ARROW_MAX_AGE_MS 内推理过时) > 车道
+        cmd = poll_command()
+        if cmd:
+            pending_cmd = cmd
+        if time.ticks_diff(time.ticks_ms(), write_ms) < FRAME_GAP_MS:
+            continue
+        if pending_cmd == CMD_COLOR:
+            with pipe_lock:
+                text = color_frame(st["color"])
+            pending_cmd = None
+        elif prob_ema is not None and time.ticks_diff(time.ticks_ms(), infer_ms) <= ARROW_MAX_AGE_MS and \
+                (pending_cmd == CMD_TURN or st["label"] != sent_label or
+                 time.ticks_diff(time.ticks_ms(), sent_ms) >= STREAM_PERIOD_MS):
+            text = arrow_frame(st["label"], st["conf"])
+            sent_label = st["label"]
+            sent_ms = time.ticks_ms()
+            pending_cmd = None
+        elif st["lane_seq"] != sent_lane:
+            with pipe_lock:
+                text = lane_frame(*st["lane"])
+                sent_lane = st["lane_seq"]
+        else:
+            continue
+        uart.write(text)
+        write_ms = time.ticks_ms()
+
+def run_sync():
+    """同步模式主循环: 收到指令后现场识别"""
     while(True):
         #cmd = update_command()
         cmd = CMD_TURN
@@ -187,30 +593,42 @@ try:
             time.sleep(1)
             #continue
         elif cmd == CMD_COLOR:
-            Find_Three_blobs(color_threshold_red,color_threshold_green,color_threshold_blue)
-            result = "AABBN"+str(RGB_blobs_num[0])+str(RGB_blobs_num[1])+str(RGB_blobs_num[2])
+            Find_Three_blobs()
+            result = color_frame(RGB_blobs_num)
             uart.write(result)
             print(result)
             cmd = CMD_WAIT
         elif cmd == CMD_TURN:
-            text = "AAAABBB"+arrow_identify()
+            label, confidence = arrow_identify()
+            text = arrow_frame(label, confidence)
             uart.write(text)
             print(text)
             cmd = CMD_WAIT
         else:
             cmd = CMD_WAIT
+
+try:
+    if PIPELINE_MODE:
+        run_pipeline()
+    else:
+        run_sync()
 except KeyboardInterrupt as e:
     print("用户停止: ", e)
 except BaseException as e:
     print(f"异常: {e}")
 
 finally:
+    pipe_state["running"] = False
+    time.sleep_ms(200)      # 等采集线程退出
+    del ai2d_builder
+    sign_builders.clear()
     del kpu
     # 停止传感器运行`
     if isinstance(sensor, Sensor):
         sensor.stop()
     # 反初始化显示模块
-    Display.deinit()
+    if not HEADLESS:
+        Display.deinit()
     os.exitpoint(os.EXITPOINT_ENABLE_SLEEP)
     time.sleep_ms(100)
     # 释放媒体缓冲区
@@ -1,9 +1,13 @@
+import os
+import numpy as np
 import torch
 import torch.nn as nn
+import torch.nn.functional as F
 import torch.optim as optim
 from torchvision import transforms, datasets
 from torch.utils.data import DataLoader
 import time
+import json
 
 
 # --- 1. 模型定义 (ArrowNet) ---
@@ -41,6 +45,36 @@ class ArrowNet(nn.Module):
         return x
 
 
+# --- 打包数据集 (generate_image.py 输出的 .npy) ---
+class PackedArrowData:
+    """
+    内存映射读取 {split}_images.npy / {split}_labels.npy，按批切片后在张量上归一化，
+    不经过 PIL 解码和逐张 transform。len() 与 ImageFolder 一样返回样本数。
+    """
+    def __init__(self, data_dir, split, input_size=64):
+        self.images = np.load(os.path.join(data_dir, f"{split}_images.npy"), mmap_mode='r')
+        self.labels = torch.from_numpy(np.load(os.path.join(data_dir, f"{split}_labels.npy")))
+        self.input_size = input_size
+        with open(os.path.join(data_dir, "dataset.json")) as f:
+            self.class_to_idx = {name: i for i, name in enumerate(json.load(f)["classes"])}
+
+    def __len__(self):
+        return len(self.labels)
+
+    def tensor(self, idx):
+        """下标 (升序 numpy 数组) -> 归一化后的 N x 1 x input_size x input_size 张量"""
+        x = torch.from_numpy(np.ascontiguousarray(self.images[idx])).unsqueeze(1).float()
+        if x.shape[-1] != self.input_size:
+            x = F.interpolate(x, size=(self.input_size, self.input_size), mode='bilinear', align_corners=False)
+        return (x / 255.0 - 0.5) / 0.5     # 与 transforms.Normalize(mean=[0.5], std=[0.5]) 相同
+
+    def batches(self, batch_size, shuffle):
+        order = torch.randperm(len(self)) if shuffle else torch.arange(len(self))
+        for start in range(0, len(self), batch_size):
+            idx = order[start:start + batch_size].sort()[0]   # 升序切片，内存映射顺序读
+            yield self.tensor(idx.numpy()), self.labels[idx]
+
+
 # --- 主执行函数 ---
 if __name__ == "__main__":
 
@@ -70,12 +104,22 @@ if __name__ == "__main__":
         ]),
     }
 
+    # generate_image.py 生成的打包数据存在时直接读取，否则按原方式读取 PNG 目录
+    packed_dir = 'dataset_v3_fixed'
     data_dir = 'picture'
-    train_dataset = datasets.ImageFolder(root=data_dir + '/train', transform=data_transform['train'])
-    val_dataset = datasets.ImageFolder(root=data_dir + '/val', transform=data_transform['val'])
-
-    train_loader = DataLoader(dataset=train_dataset, batch_size=BATCH_SIZE, shuffle=True)
-    val_loader = DataLoader(dataset=val_dataset, batch_size=BATCH_SIZE, shuffle=False)
+    if os.path.exists(os.path.join(packed_dir, 'train_images.npy')):
+        print(f"读取打包数据集: {packed_dir}")
+        train_dataset = PackedArrowData(packed_dir, 'train')
+        val_dataset = PackedArrowData(packed_dir, 'val')
+        train_loader = lambda: train_dataset.batches(BATCH_SIZE, shuffle=True)
+        val_loader = lambda: val_dataset.batches(BATCH_SIZE, shuffle=False)
+    else:
+        train_dataset = datasets.ImageFolder(root=data_dir + '/train', transform=data_transform['train'])
+        val_dataset = datasets.ImageFolder(root=data_dir + '/val', transform=data_transform['val'])
+        train_images = DataLoader(dataset=train_dataset, batch_size=BATCH_SIZE, shuffle=True)
+        val_images = DataLoader(dataset=val_dataset, batch_size=BATCH_SIZE, shuffle=False)
+        train_loader = lambda: train_images
+        val_loader = lambda: val_images
 
     print(f"训练集大小: {len(train_dataset)}, 验证集大小: {len(val_dataset)}")
     print(f"类别: {train_dataset.class_to_idx}")
@@ -96,7 +140,7 @@ if __name__ == "__main__":
         # --- 训练阶段 ---
         model.train()  # 设置为训练模式
         running_loss = 0.0
-        for images, labels in train_loader:
+        for images, labels in train_loader():
             images, labels = images.to(DEVICE), labels.to(DEVICE)
 
             # 1. 清零梯度
@@ -123,7 +167,7 @@ if __name__ == "__main__":
         val_loss = 0.0
         corrects = 0
         with torch.no_grad():  # 在此模式下，不计算梯度，节省计算资源
-            for images, labels in val_loader:
+            for images, labels in val_loader():
                 images, labels = images.to(DEVICE), labels.to(DEVICE)
 
                 outputs = model(images)
@@ -0,0 +1,240 @@
+# ArrowNet 主机端基准测试
+# 用验证集分别跑 ONNX (onnxruntime) 和 kmodel (nncase 模拟器)，统计准确率 / 混淆矩阵 / 单张推理延迟分位数 / 模型大小，
+# 结果写成 JSON，可与之前的结果对比 (--baseline)，模型改动时同时看速度和精度。
+# 预处理与 test_model.py 一致: ONNX 输入归一化后的 float32，kmodel 输入 uint8 (归一化在 kmodel 内)。
+# 注意: nncase 模拟器在主机 CPU 上逐算子仿真，其延迟只用于同类模型之间比较，不代表 K230 上 KPU 的耗时
+# (板上耗时看 UART.py 打印的 ARROW / PIPE 行)。
+#
+# 用法:
+#   python benchmark.py --models arrownet.onnx arrownet.kmodel --data ./dataset_v3_fixed/val --output bench.json
+#   python benchmark.py --models arrownet.kmodel --baseline bench.json
+import os
+import sys
+import json
+import time
+import argparse
+import platform
+import numpy as np
+
+from test_model import get_onnx_input, get_kmodel_input, onnx_inference, kmodel_inference, softmax
+
+CLASS_NAMES = ['left', 'none', 'right']     # 顺序必须和训练时 ImageFolder 的顺序一致
+MEAN = [0.5]
+STD = [0.5]
+MODEL_INPUT_SIZE = [64, 64]
+
+
+def load_dataset(data_dir, limit):
+    """返回 [(图片路径, 类别序号), ...]，每类最多 limit 张 (0 不限)"""
+    samples = []
+    for class_index, class_name in enumerate(CLASS_NAMES):
+        class_dir = os.path.join(data_dir, class_name)
+        if not os.path.isdir(class_dir):
+            print(f"Warning: missing class directory {class_dir}")
+            continue
+        names = sorted(os.listdir(class_dir))
+        if limit > 0:
+            names = names[:limit]
+        samples += [(os.path.join(class_dir, n), class_index) for n in names]
+    return samples
+
+
+class OnnxRunner:
+    backend = "onnxruntime"
+
+    def __init__(self, path):
+        import onnxruntime as ort
+        self.session = ort.InferenceSession(path)
+        self.version = ort.__version__
+
+    def prepare(self, img_path):
+        return get_onnx_input(img_path, MEAN, STD, MODEL_INPUT_SIZE)
+
+    def run(self, data):
+        return onnx_inference(self.session, data)[0]
+
+
+class KmodelRunner:
+    backend = "nncase-simulator"
+
+    def __init__(self, path):
+        import nncase
+        self.sim = nncase.Simulator()
+        with open(path, 'rb') as f:
+            self.sim.load_model(f.read())
+        self.version = getattr(nncase, "__version__", "unknown")
+
+    def prepare(self, img_path):
+        return get_kmodel_input(img_path, MODEL_INPUT_SIZE)
+
+    def run(self, data):
+        return kmodel_inference(self.sim, data, MODEL_INPUT_SIZE)[0]
+
+
+def make_runner(path):
+    ext = os.path.splitext(path)[1].lower()
+    if ext == ".onnx":
+        return OnnxRunner(path)
+    if ext == ".kmodel":
+        return KmodelRunner(path)
+    raise ValueError(f"unsupported model type: {path}")
+
+
+def percentile_ms(latencies, q):
+    return float(np.percentile(latencies, q) * 1000.0)
+
+
+def benchmark_model(path, samples, warmup):
+    """跑完整个验证集，返回结果字典和每张图的 logits (供与参考模型比较)"""
+    runner = make_runner(path)
+    inputs = []
+    for img_path, label in samples:
+        data = runner.prepare(img_path)
+        if data is None:
+            print(f"Warning: skipping invalid image file {img_path}")
+            continue
+        inputs.append((data, label))
+    if not inputs:
+        raise RuntimeError("no valid images")
+
+    for i in range(min(warmup, len(inputs))):
+        runner.run(inputs[i][0])
+
+    n = len(CLASS_NAMES)
+    confusion = np.zeros((n, n), dtype=np.int64)    # 行: 真实类别，列: 预测类别
+    latencies = []
+    logits = []
+    confidences = []
+    t_start = time.perf_counter()
+    for data, label in inputs:
+        t0 = time.perf_counter()
+        out = runner.run(data)
+        latencies.append(time.perf_counter() - t0)
+        out = np.reshape(out, (1, -1)).astype(np.float32)
+        prob = softmax(out)[0]
+        pred = int(np.argmax(prob))
+        confusion[label, pred] += 1
+        confidences.append(float(prob[pred]))
+        logits.append(out[0])
+    wall = time.perf_counter() - t_start
+
+    per_class = {}
+    for i, name in enumerate(CLASS_NAMES):
+        total = int(confusion[i].sum())
+        per_class[name] = float(confusion[i, i] / total) if total else None
+    result = {
+        "model": os.path.basename(path),
+        "path": os.path.abspath(path),
+        "backend": runner.backend,
+        "backend_version": runner.version,
+        "size_bytes": os.path.getsize(path),
+        "images": len(inputs),
+        "accuracy": float(np.trace(confusion) / confusion.sum()),
+        "per_class_accuracy": per_class,
+        "confusion_matrix": confusion.tolist(),
+        "mean_confidence": float(np.mean(confidences)),
+        "latency_ms": {
+            "mean": float(np.mean(latencies) * 1000.0),
+            "p50": percentile_ms(latencies, 50),
+            "p90": percentile_ms(latencies, 90),
+            "p99": percentile_ms(latencies, 99),
+            "max": float(np.max(latencies) * 1000.0),
+        },
+        "throughput_ips": float(len(inputs) / wall),
+    }
+    return result, np.array(logits)
+
+
+def compare_outputs(ref_logits, logits):
+    """与参考模型 (第一个模型) 逐张比较: 平均余弦相似度和预测一致率"""
+    if ref_logits.shape != logits.shape:
+        return None
+    cos = np.sum(ref_logits * logits, axis=1) / \
+        (np.linalg.norm(ref_logits, axis=1) * np.linalg.norm(logits, axis=1) + 1e-12)
+    agree = np.argmax(ref_logits, axis=1) == np.argmax(logits, axis=1)
+    return {"cosine_mean": float(np.mean(cos)), "cosine_min": float(np.min(cos)),
+            "agreement": float(np.mean(agree))}
+
+
+def print_result(r):
+    lat = r["latency_ms"]
+    print(f"\n--- {r['model']} ({r['backend']}, {r['size_bytes'] / 1024:.1f} KiB) ---")
+    print(f"Accuracy: {r['accuracy']:.4f} on {r['images']} images, mean confidence {r['mean_confidence']:.3f}")
+    print("Per class: " + ", ".join(f"{k} {v:.4f}" if v is not None else f"{k} -"
+                                    for k, v in r["per_class_accuracy"].items()))
+    print("Confusion (rows = true, cols = pred): " + " ".join(CLASS_NAMES))
+    for name, row in zip(CLASS_NAMES, r["confusion_matrix"]):
+        print(f"  {name:>6}: " + " ".join(f"{v:6d}" for v in row))
+    print(f"Latency ms: mean {lat['mean']:.3f}  p50 {lat['p50']:.3f}  p90 {lat['p90']:.3f}  "
+          f"p99 {lat['p99']:.3f}  max {lat['max']:.3f}   throughput {r['throughput_ips']:.1f} img/s")
+    if "vs_reference" in r and r["vs_reference"]:
+        v = r["vs_reference"]
+        print(f"Vs reference: cosine mean {v['cosine_mean']:.6f} (min {v['cosine_min']:.6f}), "
+              f"agreement {v['agreement']:.4f}")
+
+
+def print_baseline_diff(results, baseline_path):
+    """按模型文件名与基线 JSON 对比准确率和 p50 延迟"""
+    with open(baseline_path) as f:
+        baseline = {r["model"]: r for r in json.load(f)["results"]}
+    print(f"\n--- Compared with {baseline_path} ---")
+    for r in results:
+        b = baseline.get(r["model"])
+        if b is None:
+            print(f"{r['model']}: not in baseline")
+            continue
+        print(f"{r['model']}: accuracy {b['accuracy']:.4f} -> {r['accuracy']:.4f} "
+              f"({r['accuracy'] - b['accuracy']:+.4f}), p50 {b['latency_ms']['p50']:.3f} -> "
+              f"{r['latency_ms']['p50']:.3f} ms, size {b['size_bytes']} -> {r['size_bytes']} bytes")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="ArrowNet 基准测试 (ONNX / nncase 模拟器)")
+    parser.add_argument("--models", nargs="+", default=["arrownet.onnx", "arrownet.kmodel"],
+                        help="模型文件 (.onnx / .kmodel)，第一个作为输出比较的参考")
+    parser.add_argument("--data", default="./dataset_v3_fixed/val", help="验证集目录 (按类别分子目录)")
+    parser.add_argument("--limit", type=int, default=0, help="每类最多使用的图片数，0 不限")
+    parser.add_argument("--warmup", type=int, default=5, help="计时前的预热推理次数")
+    parser.add_argument("--output", default="benchmark.json", help="结果 JSON 路径")
+    parser.add_argument("--baseline", default=None, help="之前的结果 JSON，打印对比")
+    args = parser.parse_args()
+
+    samples = load_dataset(args.data, args.limit)
+    if not samples:
+        print(f"Error: no images found in {args.data}")
+        return 1
+    print(f"Dataset: {args.data}, {len(samples)} images")
+
+    results = []
+    ref_logits = None
+    for path in args.models:
+        print(f"Running {path} ...")
+        result, logits = benchmark_model(path, samples, args.warmup)
+        if ref_logits is None:
+            ref_logits = logits
+        else:
+            result["vs_reference"] = compare_outputs(ref_logits, logits)
+        print_result(result)
+        results.append(result)
+
+    report = {
+        "time": time.strftime("%Y-%m-%d %H:%M:%S"),
+        "host": {"platform": platform.platform(), "python": platform.python_version(),
+                 "processor": platform.processor()},
+        "dataset": os.path.abspath(args.data),
+        "classes": CLASS_NAMES,
+        "input_size": MODEL_INPUT_SIZE,
+        "note": "nncase-simulator latency is host CPU simulation time, not K230 KPU time",
+        "results": results,
+    }
+    with open(args.output, "w") as f:
+        json.dump(report, f, indent=2)
+    print(f"\nResults written to {args.output}")
+
+    if args.baseline:
+        print_baseline_diff(results, args.baseline)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
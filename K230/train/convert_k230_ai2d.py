@@ -98,39 +98,37 @@ def generate_data(shape, batch, calib_dir):
     return np.array(data)
 
 
-def main():
-    # 命令行参数定义
-    parser = argparse.ArgumentParser(prog="nncase")
-    parser.add_argument("--target", default="k230", type=str, help='编译目标，例如k230或cpu')
-    parser.add_argument("--model", type=str, required=True, help='输入ONNX模型路径')
-    parser.add_argument("--dataset_path", type=str, required=True, help='PTQ校准数据集路径')
-    parser.add_argument("--input_width", type=int, required=True, help='模型输入宽度')
-    parser.add_argument("--input_height", type=int, required=True, help='模型输入高度')
-    parser.add_argument("--ptq_option", type=int, default=0, help='PTQ选项：0-5')
+# 支持6种量化方案（根据精度与性能权衡选择）
+PTQ_METHODS = [
+    ('NoClip', 'uint8', 'uint8'), ('NoClip', 'uint8', 'int16'),
+    ('NoClip', 'int16', 'uint8'), ('Kld', 'uint8', 'uint8'),
+    ('Kld', 'uint8', 'int16'), ('Kld', 'int16', 'uint8')
+]
 
-    args = parser.parse_args()
 
+def compile_kmodel(model, dataset_path, input_width, input_height, ptq_option=0, target="k230",
+                   kmodel_name=None, samples_count=20, dump_dir='tmp'):
+    """ONNX -> kmodel，返回生成的 kmodel 路径 (quant_pipeline.py 扫描 ptq_option 时复用)"""
     # ---【修改点 2：适配ArrowNet模型的输入形状】---
     # 输入尺寸应与你的模型匹配。64已经是32的倍数，所以对齐操作不会改变它。
-    input_width = int(math.ceil(args.input_width / 32.0)) * 32
-    input_height = int(math.ceil(args.input_height / 32.0)) * 32
+    input_width = int(math.ceil(input_width / 32.0)) * 32
+    input_height = int(math.ceil(input_height / 32.0)) * 32
     # 将输入通道数从 3 修改为 1
     input_shape = [1, 1, input_height, input_width]  # NCHW格式
 
     # 创建临时目录保存中间模型
-    dump_dir = 'tmp'
     if not os.path.exists(dump_dir):
         os.makedirs(dump_dir)
 
     # 简化模型
     print("Step 1: Simplifying ONNX model...")
-    model_file = onnx_simplify(args.model, dump_dir, input_shape)
+    model_file = onnx_simplify(model, dump_dir, input_shape)
     print(f"ONNX model simplified and saved to {model_file}")
 
     # ---【修改点 3：适配ArrowNet模型的预处理参数】---
     # 编译选项设置
     compile_options = nncase.CompileOptions()
-    compile_options.target = args.target  # 指定目标平台
+    compile_options.target = target  # 指定目标平台
     compile_options.preprocess = True  # 启用预处理
     compile_options.swapRB = False  # 灰度图此项无意义
     compile_options.input_shape = input_shape  # 设置输入形状
@@ -157,23 +155,17 @@ def main():
     # PTQ选项设置（后训练量化）
     print("Step 3: Setting up PTQ options...")
     ptq_options = nncase.PTQTensorOptions()
-    ptq_options.samples_count = 20  # 校准样本数量，10-20张通常足够
-
-    # 支持6种量化方案（根据精度与性能权衡选择）
-    ptq_methods = [
-        ('NoClip', 'uint8', 'uint8'), ('NoClip', 'uint8', 'int16'),
-        ('NoClip', 'int16', 'uint8'), ('Kld', 'uint8', 'uint8'),
-        ('Kld', 'uint8', 'int16'), ('Kld', 'int16', 'uint8')
-    ]
-    method, q_type, w_q_type = ptq_methods[args.ptq_option]
+    ptq_options.samples_count = samples_count  # 校准样本数量，10-20张通常足够
+
+    method, q_type, w_q_type = PTQ_METHODS[ptq_option]
     ptq_options.calibrate_method = method
     ptq_options.quant_type = q_type
     ptq_options.w_quant_type = w_q_type
-    print(f"Using PTQ option {args.ptq_option}: method={method}, quant_type={q_type}, w_quant_type={w_q_type}")
+    print(f"Using PTQ option {ptq_option}: method={method}, quant_type={q_type}, w_quant_type={w_q_type}")
 
     # 设置PTQ校准数据
-    print(f"Generating calibration data from {args.dataset_path}...")
-    ptq_options.set_tensor_data(generate_data(input_shape, ptq_options.samples_count, args.dataset_path))
+    print(f"Generating calibration data from {dataset_path}...")
+    ptq_options.set_tensor_data(generate_data(input_shape, ptq_options.samples_count, dataset_path))
 
     # 应用PTQ
     compiler.use_ptq(ptq_options)
@@ -185,8 +177,9 @@ def main():
     print("Compilation complete.")
 
     # 导出KModel文件
-    base, ext = os.path.splitext(args.model)
-    kmodel_name = base + ".kmodel"
+    if kmodel_name is None:
+        base, ext = os.path.splitext(model)
+        kmodel_name = base + ".kmodel"
     print(f"Step 5: Generating KModel file: {kmodel_name}...")
     with open(kmodel_name, 'wb') as f:
         f.write(compiler.gencode_tobytes())
@@ -194,6 +187,22 @@ def main():
     # 清理临时文件
     shutil.rmtree(dump_dir)
     print(f"\nSuccessfully generated {kmodel_name}!")
+    return kmodel_name
+
+
+def main():
+    # 命令行参数定义
+    parser = argparse.ArgumentParser(prog="nncase")
+    parser.add_argument("--target", default="k230", type=str, help='编译目标，例如k230或cpu')
+    parser.add_argument("--model", type=str, required=True, help='输入ONNX模型路径')
+    parser.add_argument("--dataset_path", type=str, required=True, help='PTQ校准数据集路径')
+    parser.add_argument("--input_width", type=int, required=True, help='模型输入宽度')
+    parser.add_argument("--input_height", type=int, required=True, help='模型输入高度')
+    parser.add_argument("--ptq_option", type=int, default=0, help='PTQ选项：0-5')
+
+    args = parser.parse_args()
+    compile_kmodel(args.model, args.dataset_path, args.input_width, args.input_height,
+                   ptq_option=args.ptq_option, target=args.target)
 
 
 # Python程序主入口
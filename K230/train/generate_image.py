@@ -1,5 +1,21 @@
+# 合成箭头数据集
+# 多进程并行生成，每张图用 (seed, split, 类别, 序号) 派生的独立种子，结果与进程数无关、可复现。
+# 输出为打包的 uint8 张量 (.npy，训练时 np.load(mmap_mode='r') 直接映射，不再逐张解码 PNG):
+#   {split}_images.npy  N x IMAGE_SIZE x IMAGE_SIZE uint8
+#   {split}_labels.npy  N int64，类别序号按 PACKED_CLASSES (与 ImageFolder 的字母序一致)
+#   {split}_meta.npy    每张图的生成参数 (种子 / 旋转角 / 背景亮度 / 噪声强度 ...)
+#   dataset.json        配置、类别和各 split 的样本数
+# --png val (默认) 另外写出验证集 PNG 目录，供 benchmark.py / test_model.py / 量化校准使用；--png all 连训练集一起写。
+#
+# 用法:
+#   python generate_image.py --seed 0 --workers 8
+#   python generate_image.py --train 5000 --val 500 --png all
 import os
+import json
+import time
 import random
+import argparse
+from multiprocessing import Pool
 from PIL import Image, ImageDraw, ImageOps
 import numpy as np
 from tqdm import tqdm
@@ -11,41 +27,52 @@ VAL_SAMPLES_PER_CLASS = 200
 BASE_DIR = 'dataset_v3_fixed'  # 改个名防止覆盖
 
 CLASSES = ['left', 'right', 'none']
+PACKED_CLASSES = sorted(CLASSES)  # 打包数据的标签顺序，与 ImageFolder 一致: left, none, right
 ROTATION_RANGE = (0, 180)  # 0到180度旋转
+CHUNK = 250  # 每个进程任务生成的张数
+
+META_DTYPE = np.dtype([
+    ('seed', np.uint32), ('angle', np.float32), ('bg', np.uint8), ('dots', np.uint8),
+    ('lines', np.uint8), ('thickness', np.uint8), ('noise_std', np.float32)
+])
 
 
 # --- 辅助函数 ---
 
-def create_directories():
+def create_directories(png_splits):
     if not os.path.exists(BASE_DIR):
         print(f"创建数据集目录: {BASE_DIR}")
-    for split in ['train', 'val']:
+    os.makedirs(BASE_DIR, exist_ok=True)
+    for split in png_splits:
         for class_name in CLASSES:
             os.makedirs(os.path.join(BASE_DIR, split, class_name), exist_ok=True)
 
 
-def add_gaussian_noise(image):
+def add_gaussian_noise(image, meta):
     """最后的噪点处理，模拟摄像头噪点"""
     img_array = np.array(image, dtype=np.float32)
     mean = 0
     std_dev = random.uniform(2, 8)  # 稍微降低一点噪点，保证箭头清晰
+    meta['noise_std'] = std_dev
     noise = np.random.normal(mean, std_dev, img_array.shape)
     noisy_array = img_array + noise
     noisy_array = np.clip(noisy_array, 0, 255)
     return Image.fromarray(noisy_array.astype('uint8'), 'L')
 
 
-def generate_base_background():
+def generate_base_background(meta):
     """
     生成背景：深灰色背景 + 黑色圆点 + 随机干扰线
     """
     # 背景色调暗一些 (50-100)，让白箭头突出来
     bg_color = random.randint(50, 100)
+    meta['bg'] = bg_color
     image = Image.new('L', (IMAGE_SIZE, IMAGE_SIZE), color=bg_color)
     draw = ImageDraw.Draw(image)
 
     # 1. 绘制黑色圆点 (核心干扰项)
     num_dots = random.randint(3, 10)
+    meta['dots'] = num_dots
     for _ in range(num_dots):
         r = random.randint(2, 4)
         x = random.randint(0, IMAGE_SIZE)
@@ -56,6 +83,7 @@ def generate_base_background():
 
     # 2. 绘制一些随机线条 (模拟划痕或背景纹理)
     num_lines = random.randint(1, 3)
+    meta['lines'] = num_lines
     for _ in range(num_lines):
         x1, y1 = random.randint(0, IMAGE_SIZE), random.randint(0, IMAGE_SIZE)
         x2, y2 = random.randint(0, IMAGE_SIZE), random.randint(0, IMAGE_SIZE)
@@ -65,7 +93,7 @@ def generate_base_background():
     return image
 
 
-def create_arrow_layer(direction):
+def create_arrow_layer(direction, meta):
     """
     在透明图层上绘制类似路牌的粗壮L型箭头。
     返回: RGBA Image
@@ -82,6 +110,7 @@ def create_arrow_layer(direction):
     cx, cy = IMAGE_SIZE // 2, IMAGE_SIZE // 2
 
     thickness = random.randint(7, 9)  # 线条粗细
+    meta['thickness'] = thickness
     shaft_len = random.randint(16, 22)  # 竖杆长度
     arm_len = random.randint(14, 20)  # 横杆长度
     head_size = random.randint(10, 14)  # 三角形大小
@@ -139,21 +168,27 @@ def create_arrow_layer(direction):
     return layer
 
 
-def generate_sample(class_name):
+def generate_sample(class_name, seed):
     """
     生成单个样本：
     背景 -> 叠加旋转后的箭头 -> 噪声
+    返回 (图片, 生成参数)
     """
+    random.seed(seed)
+    np.random.seed(seed)
+    meta = {'seed': seed, 'angle': np.nan, 'thickness': 0}
+
     # 1. 生成统一背景 (含黑点)
-    base_image = generate_base_background()
+    base_image = generate_base_background(meta)
 
     # 2. 如果不是 none 类，叠加箭头
     if class_name in ['left', 'right']:
         # 获取箭头图层
-        arrow_layer = create_arrow_layer(class_name)
+        arrow_layer = create_arrow_layer(class_name, meta)
 
         # 随机旋转
         angle = random.uniform(ROTATION_RANGE[0], ROTATION_RANGE[1])
+        meta['angle'] = angle
 
         # 旋转图层 (resample=Image.BICUBIC 保证边缘不锯齿)
         rotated_layer = arrow_layer.rotate(angle, resample=Image.BICUBIC, expand=False)
@@ -162,31 +197,82 @@ def generate_sample(class_name):
         base_image.paste(rotated_layer, (0, 0), rotated_layer)
 
     # 3. 添加最后的高斯噪声
-    final_image = add_gaussian_noise(base_image)
+    final_image = add_gaussian_noise(base_image, meta)
 
-    return final_image
+    return final_image, meta
 
 
 # --- 主程序 ---
 
-def generate_dataset():
-    create_directories()
+def sample_seed(seed, split, class_name, index):
+    """每张图的独立种子，只取决于位置，与进程数和生成顺序无关"""
+    ss = np.random.SeedSequence([seed, ['train', 'val'].index(split), CLASSES.index(class_name), index])
+    return int(ss.generate_state(1)[0])
+
+
+def render_chunk(task):
+    """子进程: 生成 [start, end) 的样本，写入共享的 .npy 内存映射，返回这段的生成参数"""
+    split, class_name, offset, start, end, seed, write_png = task
+    images = np.lib.format.open_memmap(os.path.join(BASE_DIR, f"{split}_images.npy"), mode='r+')
+    meta = np.zeros(end - start, dtype=META_DTYPE)
+    for i in range(start, end):
+        img, m = generate_sample(class_name, sample_seed(seed, split, class_name, i))
+        images[offset + i] = np.asarray(img, dtype=np.uint8)
+        for k in META_DTYPE.names:
+            meta[i - start][k] = m[k]
+        if write_png:
+            img.save(os.path.join(BASE_DIR, split, class_name, f"{i:05d}.png"))
+    images.flush()
+    del images
+    return split, offset + start, meta
+
+
+def generate_dataset(seed, workers, counts, png_splits):
+    create_directories(png_splits)
     print(f"开始生成数据集...")
-    print(f"配置: 尺寸{IMAGE_SIZE}x{IMAGE_SIZE}, 旋转{ROTATION_RANGE}, 箭头样式: 粗线L型")
-
-    for split in ['train', 'val']:
-        samples = TRAIN_SAMPLES_PER_CLASS if split == 'train' else VAL_SAMPLES_PER_CLASS
-
-        for class_name in CLASSES:
-            output_dir = os.path.join(BASE_DIR, split, class_name)
-            print(f"正在生成 {split} - {class_name} ...")
-
-            for i in tqdm(range(samples)):
-                img = generate_sample(class_name)
-                img.save(os.path.join(output_dir, f"{i:05d}.png"))
-
-    print("\n搞定。请查看 dataset_v3_fixed 文件夹。")
+    print(f"配置: 尺寸{IMAGE_SIZE}x{IMAGE_SIZE}, 旋转{ROTATION_RANGE}, 箭头样式: 粗线L型, 种子 {seed}, 进程 {workers}")
+    start_time = time.time()
+
+    tasks = []
+    metas = {}
+    for split, samples in counts.items():
+        n = samples * len(PACKED_CLASSES)
+        np.lib.format.open_memmap(os.path.join(BASE_DIR, f"{split}_images.npy"), mode='w+',
+                                  dtype=np.uint8, shape=(n, IMAGE_SIZE, IMAGE_SIZE)).flush()
+        np.save(os.path.join(BASE_DIR, f"{split}_labels.npy"),
+                np.repeat(np.arange(len(PACKED_CLASSES), dtype=np.int64), samples))
+        metas[split] = np.zeros(n, dtype=META_DTYPE)
+        for label, class_name in enumerate(PACKED_CLASSES):
+            for start in range(0, samples, CHUNK):
+                tasks.append((split, class_name, label * samples, start, min(start + CHUNK, samples),
+                              seed, split in png_splits))
+
+    with Pool(workers) as pool, tqdm(total=sum(c * len(PACKED_CLASSES) for c in counts.values())) as bar:
+        for split, pos, meta in pool.imap_unordered(render_chunk, tasks):
+            metas[split][pos:pos + len(meta)] = meta
+            bar.update(len(meta))
+
+    for split, meta in metas.items():
+        np.save(os.path.join(BASE_DIR, f"{split}_meta.npy"), meta)
+    info = {
+        "image_size": IMAGE_SIZE, "classes": PACKED_CLASSES, "seed": seed,
+        "rotation_range": ROTATION_RANGE, "samples": {k: v * len(PACKED_CLASSES) for k, v in counts.items()},
+        "png": png_splits,
+    }
+    with open(os.path.join(BASE_DIR, "dataset.json"), "w") as f:
+        json.dump(info, f, indent=2)
+
+    print(f"\n搞定，用时 {time.time() - start_time:.1f}s。请查看 {BASE_DIR} 文件夹。")
 
 
 if __name__ == '__main__':
-    generate_dataset()
\ No newline at end of file
+    parser = argparse.ArgumentParser(description="并行生成箭头数据集 (打包 .npy + 可选 PNG)")
+    parser.add_argument("--seed", type=int, default=0, help="随机种子，相同种子生成完全相同的数据集")
+    parser.add_argument("--workers", type=int, default=os.cpu_count(), help="进程数")
+    parser.add_argument("--train", type=int, default=TRAIN_SAMPLES_PER_CLASS, help="训练集每类张数")
+    parser.add_argument("--val", type=int, default=VAL_SAMPLES_PER_CLASS, help="验证集每类张数")
+    parser.add_argument("--png", choices=["none", "val", "all"], default="val", help="同时写出 PNG 目录的 split")
+    args = parser.parse_args()
+
+    png_splits = {"none": [], "val": ["val"], "all": ["train", "val"]}[args.png]
+    generate_dataset(args.seed, args.workers, {"train": args.train, "val": args.val}, png_splits)
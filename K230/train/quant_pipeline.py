@@ -0,0 +1,297 @@
+# ArrowNet 量化流水线: (可选) 量化感知微调 -> 导出 ONNX -> 自动选校准集 -> 扫描 ptq_option 编译 kmodel
+# -> 用验证集评估 (benchmark.py) -> 输出满足精度下限的最快 kmodel 和 JSON 报告
+#
+# 1. 量化感知微调 (--qat-epochs > 0): 在 arrow_detect.py 训练好的浮点权重上继续训练几轮，
+#    卷积 / 全连接权重按输出通道做 int8 伪量化，ReLU 输出按滑动最大值做 uint8 伪量化 (直通估计反传)，
+#    权重和激活学会容忍量化误差后，导出普通浮点 ONNX 交给 nncase 做 PTQ (nncase 不读取 PyTorch 的量化节点)。
+#    nncase 编译时会把 BN 折叠进卷积，折叠后的量化网格与训练时不完全一致，但误差远小于直接 PTQ。
+# 2. 校准集: 用浮点模型的全局池化特征对训练集按类别做 k-means，每个簇取离中心最近的一张，
+#    覆盖各类别和各种背景 / 亮度 / 角度，而不是目录里排在前面的 20 张。
+# 3. 扫描 ptq_option (convert_k230_ai2d.PTQ_METHODS)，每个 kmodel 在 nncase 模拟器上跑验证集。
+#    精度下限: --min-accuracy，未给出时取浮点 ONNX 准确率 - --max-drop。
+#    满足下限的按 KPU 代价排序: int16 激活 (2) + int16 权重 (1)，同代价时取模拟器 p50 延迟小的。
+#
+# 数据集默认读 generate_image.py 的打包输出 (dataset_v3_fixed/{split}_images.npy，与 arrow_detect.py 相同)，
+# 没有打包数据时读 <data>/train、<data>/val 的 PNG 目录；kmodel 评估始终用 <data>/val 的 PNG (生成器默认写出)。
+#
+# 用法:
+#   python quant_pipeline.py --checkpoint arrownet_model.pth --qat-epochs 3 --output arrownet.kmodel
+#   python quant_pipeline.py --checkpoint arrownet_model.pth --data picture --input-size 96 --qat-epochs 5
+import os
+import sys
+import json
+import time
+import shutil
+import argparse
+import numpy as np
+import torch
+import torch.nn as nn
+import torch.nn.utils.parametrize as parametrize
+from PIL import Image
+from torchvision import transforms, datasets
+from torch.utils.data import DataLoader
+
+import benchmark
+from arrow_detect import ArrowNet, PackedArrowData
+from convert_k230_ai2d import compile_kmodel, PTQ_METHODS
+
+
+# --- 1. 量化感知微调 ---
+class WeightFakeQuant(nn.Module):
+    """权重按输出通道对称 int8 伪量化，前向用量化值，反向直通"""
+    def forward(self, w):
+        scale = w.detach().abs().reshape(w.shape[0], -1).max(dim=1)[0].clamp(min=1e-8) / 127.0
+        scale = scale.reshape([-1] + [1] * (w.dim() - 1))
+        q = torch.clamp(torch.round(w / scale), -127, 127) * scale
+        return w + (q - w).detach()
+
+
+class ActFakeQuant:
+    """ReLU 输出 uint8 伪量化，量化范围取滑动最大值 (forward hook)"""
+    def __init__(self, momentum=0.1):
+        self.momentum = momentum
+        self.max_val = None
+
+    def __call__(self, module, inputs, output):
+        if module.training:
+            cur = output.detach().max()
+            self.max_val = cur if self.max_val is None else \
+                (1 - self.momentum) * self.max_val + self.momentum * cur
+        if self.max_val is None:
+            return output
+        scale = self.max_val.clamp(min=1e-8) / 255.0
+        q = torch.clamp(torch.round(output / scale), 0, 255) * scale
+        return output + (q - output).detach()
+
+
+def make_loaders(data_dir, input_size, batch_size):
+    """返回 (训练集, 训练批次迭代器工厂, 验证批次迭代器工厂)；有打包数据时读 .npy，否则读 PNG 目录"""
+    if os.path.exists(os.path.join(data_dir, 'train_images.npy')):
+        print(f"读取打包数据集: {data_dir}")
+        train_dataset = PackedArrowData(data_dir, 'train', input_size)
+        val_dataset = PackedArrowData(data_dir, 'val', input_size)
+        return (train_dataset, lambda: train_dataset.batches(batch_size, shuffle=True),
+                lambda: val_dataset.batches(batch_size, shuffle=False))
+    tf = transforms.Compose([
+        transforms.Grayscale(num_output_channels=1),
+        transforms.Resize((input_size, input_size)),
+        transforms.ToTensor(),
+        transforms.Normalize(mean=[0.5], std=[0.5])
+    ])
+    train_dataset = datasets.ImageFolder(root=os.path.join(data_dir, 'train'), transform=tf)
+    val_dataset = datasets.ImageFolder(root=os.path.join(data_dir, 'val'), transform=tf)
+    train_images = DataLoader(train_dataset, batch_size=batch_size, shuffle=True)
+    val_images = DataLoader(val_dataset, batch_size=batch_size, shuffle=False)
+    return train_dataset, lambda: train_images, lambda: val_images
+
+
+def evaluate(model, loader, device):
+    model.eval()
+    corrects = total = 0
+    with torch.no_grad():
+        for images, labels in loader():
+            preds = model(images.to(device)).argmax(1)
+            corrects += (preds == labels.to(device)).sum().item()
+            total += labels.size(0)
+    return corrects / max(total, 1)
+
+
+def qat_finetune(model, train_dataset, train_loader, val_loader, epochs, lr, device):
+    """挂上伪量化微调 epochs 轮，结束后把量化后的权重固化为普通参数并去掉激活伪量化"""
+    layers = [m for m in model.modules() if isinstance(m, (nn.Conv2d, nn.Linear))]
+    for m in layers:
+        parametrize.register_parametrization(m, "weight", WeightFakeQuant())
+    hooks = [m.register_forward_hook(ActFakeQuant()) for m in model.modules() if isinstance(m, nn.ReLU)]
+
+    criterion = nn.CrossEntropyLoss()
+    optimizer = torch.optim.Adam(model.parameters(), lr=lr)
+    for epoch in range(epochs):
+        start_time = time.time()
+        model.train()
+        running_loss = 0.0
+        for images, labels in train_loader():
+            images, labels = images.to(device), labels.to(device)
+            optimizer.zero_grad()
+            loss = criterion(model(images), labels)
+            loss.backward()
+            optimizer.step()
+            running_loss += loss.item() * images.size(0)
+        acc = evaluate(model, val_loader, device)
+        print(f"QAT epoch {epoch + 1}/{epochs} | Time: {time.time() - start_time:.2f}s | "
+              f"Train Loss: {running_loss / len(train_dataset):.4f} | Val Acc (fake-quant): {acc:.4f}")
+
+    for m in layers:
+        parametrize.remove_parametrizations(m, "weight", leave_parametrized=True)
+    for h in hooks:
+        h.remove()
+    return model
+
+
+def export_onnx(model, path, input_size):
+    """与 model_transform.py 相同的导出设置"""
+    model.eval()
+    dummy_input = torch.randn((1, 1, input_size, input_size), device='cpu')
+    torch.onnx.export(model.cpu(), dummy_input, path, opset_version=11,
+                      input_names=['input'], output_names=['output'],
+                      dynamic_axes={'input': {0: 'batch_size'}, 'output': {0: 'batch_size'}})
+
+
+# --- 2. 校准集选择 ---
+def kmeans(x, k, iters=30, seed=0):
+    """简单 k-means，返回每个簇离中心最近的样本下标"""
+    rng = np.random.default_rng(seed)
+    k = min(k, len(x))
+    centers = x[rng.choice(len(x), k, replace=False)]
+    for _ in range(iters):
+        assign = np.argmin(((x[:, None, :] - centers[None, :, :]) ** 2).sum(-1), axis=1)
+        for c in range(k):
+            if np.any(assign == c):
+                centers[c] = x[assign == c].mean(0)
+    dist = ((x[:, None, :] - centers[None, :, :]) ** 2).sum(-1)
+    return sorted(set(int(np.argmin(dist[:, c])) for c in range(k)))
+
+
+def sample_tensor(dataset, indices):
+    """按下标 (升序) 取归一化后的输入张量"""
+    if isinstance(dataset, PackedArrowData):
+        return dataset.tensor(np.asarray(indices))
+    return torch.stack([dataset[j][0] for j in indices])
+
+
+def save_sample(dataset, idx, calib_dir, n):
+    """打包数据从内存映射写出 PNG，PNG 目录直接复制"""
+    if isinstance(dataset, PackedArrowData):
+        Image.fromarray(np.asarray(dataset.images[idx])).save(os.path.join(calib_dir, f"{n:03d}_{idx:05d}.png"))
+    else:
+        src = dataset.samples[idx][0]
+        shutil.copy(src, os.path.join(calib_dir, f"{n:03d}_{os.path.basename(src)}"))
+
+
+def select_calibration(model, train_dataset, count, calib_dir, device, max_per_class=2000):
+    """按类别平均分配名额，每类用池化特征做 k-means 选代表样本，写到 calib_dir"""
+    model.eval()
+    extractor = nn.Sequential(model.features, nn.AdaptiveAvgPool2d(1), nn.Flatten())
+    if isinstance(train_dataset, PackedArrowData):
+        all_labels = train_dataset.labels.tolist()
+    else:
+        all_labels = [label for _, label in train_dataset.samples]
+    by_class = {}
+    for idx, label in enumerate(all_labels):
+        by_class.setdefault(label, []).append(idx)
+
+    if os.path.exists(calib_dir):
+        shutil.rmtree(calib_dir)
+    os.makedirs(calib_dir)
+    n_class = len(by_class)
+    chosen = []
+    for i, (label, indices) in enumerate(sorted(by_class.items())):
+        quota = count // n_class + (1 if i < count % n_class else 0)
+        indices = indices[:max_per_class]
+        with torch.no_grad():
+            feats = np.concatenate([
+                extractor(sample_tensor(train_dataset, indices[s:s + 256]).to(device)).cpu().numpy()
+                for s in range(0, len(indices), 256)])
+        chosen += [indices[j] for j in kmeans(feats, quota)]
+    for n, idx in enumerate(chosen):
+        save_sample(train_dataset, idx, calib_dir, n)
+    print(f"Calibration set: {len(chosen)} images -> {calib_dir}")
+    return len(chosen)
+
+
+# --- 3. ptq_option 扫描与选择 ---
+def ptq_cost(option):
+    _, q_type, w_q_type = PTQ_METHODS[option]
+    return (2 if q_type == 'int16' else 0) + (1 if w_q_type == 'int16' else 0)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="ArrowNet QAT + PTQ 扫描，输出满足精度下限的最快 kmodel")
+    parser.add_argument("--checkpoint", default="arrownet_model.pth", help="arrow_detect.py 训练出的浮点权重")
+    parser.add_argument("--data", default="dataset_v3_fixed",
+                        help="数据集目录 (generate_image.py 的打包输出，或含 train / val 的 PNG 目录)")
+    parser.add_argument("--input-size", type=int, default=64, help="模型输入边长 (改变时应配合 QAT 微调)")
+    parser.add_argument("--qat-epochs", type=int, default=0, help="量化感知微调轮数，0 不微调")
+    parser.add_argument("--qat-lr", type=float, default=1e-4)
+    parser.add_argument("--batch-size", type=int, default=32)
+    parser.add_argument("--calib-count", type=int, default=20, help="校准样本数")
+    parser.add_argument("--ptq-options", type=int, nargs="+", default=list(range(len(PTQ_METHODS))))
+    parser.add_argument("--min-accuracy", type=float, default=None, help="kmodel 准确率下限")
+    parser.add_argument("--max-drop", type=float, default=0.01, help="未给出下限时，允许相对浮点 ONNX 的准确率下降")
+    parser.add_argument("--limit", type=int, default=0, help="评估时每类最多使用的图片数，0 不限")
+    parser.add_argument("--work-dir", default="quant_work")
+    parser.add_argument("--output", default="arrownet.kmodel", help="选中的 kmodel 复制到这里")
+    parser.add_argument("--report", default="quant_report.json")
+    args = parser.parse_args()
+
+    device = "cuda" if torch.cuda.is_available() else "cpu"
+    os.makedirs(args.work_dir, exist_ok=True)
+    benchmark.MODEL_INPUT_SIZE[:] = [args.input_size, args.input_size]
+
+    model = ArrowNet(num_classes=3)
+    model.load_state_dict(torch.load(args.checkpoint, map_location='cpu'))
+    model.to(device)
+    train_dataset, train_loader, val_loader = make_loaders(args.data, args.input_size, args.batch_size)
+    print(f"Float val accuracy: {evaluate(model, val_loader, device):.4f}")
+
+    if args.qat_epochs > 0:
+        model = qat_finetune(model, train_dataset, train_loader, val_loader, args.qat_epochs, args.qat_lr, device)
+        torch.save(model.state_dict(), os.path.join(args.work_dir, 'arrownet_qat.pth'))
+
+    onnx_path = os.path.join(args.work_dir, 'arrownet.onnx')
+    calib_dir = os.path.join(args.work_dir, 'calib')
+    calib_count = select_calibration(model.to(device), train_dataset, args.calib_count, calib_dir, device)
+    export_onnx(model, onnx_path, args.input_size)
+
+    samples = benchmark.load_dataset(os.path.join(args.data, 'val'), args.limit)
+    ref, ref_logits = benchmark.benchmark_model(onnx_path, samples, warmup=5)
+    benchmark.print_result(ref)
+    floor = args.min_accuracy if args.min_accuracy is not None else ref["accuracy"] - args.max_drop
+    print(f"Accuracy floor: {floor:.4f}")
+
+    results = []
+    for option in args.ptq_options:
+        kmodel_path = os.path.join(args.work_dir, f"arrownet_ptq{option}.kmodel")
+        try:
+            compile_kmodel(onnx_path, calib_dir, args.input_size, args.input_size, ptq_option=option,
+                           kmodel_name=kmodel_path, samples_count=calib_count,
+                           dump_dir=os.path.join(args.work_dir, 'tmp'))
+        except Exception as e:
+            print(f"PTQ option {option} failed: {e}")
+            continue
+        result, logits = benchmark.benchmark_model(kmodel_path, samples, warmup=5)
+        result["vs_reference"] = benchmark.compare_outputs(ref_logits, logits)
+        result["ptq_option"] = option
+        result["ptq_method"] = list(PTQ_METHODS[option])
+        result["kpu_cost"] = ptq_cost(option)
+        result["meets_floor"] = result["accuracy"] >= floor
+        benchmark.print_result(result)
+        results.append(result)
+
+    passing = [r for r in results if r["meets_floor"]]
+    best = min(passing, key=lambda r: (r["kpu_cost"], r["latency_ms"]["p50"])) if passing else None
+    report = {
+        "time": time.strftime("%Y-%m-%d %H:%M:%S"),
+        "checkpoint": os.path.abspath(args.checkpoint),
+        "input_size": args.input_size,
+        "qat_epochs": args.qat_epochs,
+        "calibration_images": calib_count,
+        "accuracy_floor": floor,
+        "reference": ref,
+        "results": results,
+        "selected": best["model"] if best else None,
+    }
+    with open(args.report, "w") as f:
+        json.dump(report, f, indent=2)
+    print(f"\nReport written to {args.report}")
+
+    if best is None:
+        print("Error: no kmodel meets the accuracy floor")
+        return 1
+    shutil.copy(best["path"], args.output)
+    print(f"Selected PTQ option {best['ptq_option']} {best['ptq_method']}: accuracy {best['accuracy']:.4f}, "
+          f"{best['size_bytes']} bytes -> {args.output}")
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
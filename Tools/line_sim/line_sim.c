@@ -0,0 +1,347 @@
+/*
+ * 循迹主机仿真：比较不同转向控制器在多大 MAX_BASE_SPEED 下丢线
+ *
+ * 编译运行 (在仓库根目录):
+ *   gcc -O2 -IHardware Tools/line_sim/line_sim.c Hardware/STEER_CTRL.c -lm -o line_sim
+ *   ./line_sim            # 扫描速度，输出每个控制器的丢线速度
+ *   ./line_sim -v 30      # 只跑速度 30，逐拍打印横向偏差
+ *
+ * 加上 -DPROFILE_HOST 和 Hardware/PROFILE.c 编译时，结束后打印 Steer_Ctrl_Update 的耗时统计:
+ *   gcc -O2 -DPROFILE_HOST -IHardware Tools/line_sim/line_sim.c Hardware/STEER_CTRL.c Hardware/PROFILE.c -lm -o line_sim
+ *
+ * 模型说明 (参数尽量贴近实车，但仍需实车校准):
+ *   - 差速两轮运动学，电机一阶惯性 + 起步死区
+ *   - 4 路数字红外传感器，位于轴心前方，映射表与 Get_Line_Error 一致
+ *   - 控制周期 10ms (MotorTaskEntry 中 osDelay(10))，陀螺仪带白噪声
+ *   - 前视 (K230 车道几何) 用赛道几何合成: 车头前方近 / 中 / 远三点到赛道的横向距离，
+ *     按 UART.py lane_measure 的方式得到前视偏移和弯曲度，按摄像头帧率刷新 (采样保持即为视觉延迟)
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "STEER_CTRL.h"
+#ifdef PROFILE_HOST
+#include "PROFILE.h"
+#else
+#define PROF_BEGIN(site)
+#define PROF_END(site)
+#endif
+
+/* ---------------- 车辆与赛道参数 ---------------- */
+#define SIM_DT              0.001f      // 物理步长 (s)
+#define CTRL_PERIOD_MS      10          // 控制周期 (ms)
+#define WHEEL_BASE          0.150f      // 轮距 (m)
+#define V_MAX               2.00f       // PWM 100% 时的轮速 (m/s)
+#define MOTOR_TAU           0.150f      // 电机时间常数 (s)
+#define MOTOR_STICTION      12          // 低于此 PWM 电机不转
+#define SENSOR_AHEAD        0.100f      // 传感器排到轴心的距离 (m)
+#define SENSOR_ACTIVE_HALF  0.013f      // 线半宽 + 光斑半径 (m)
+#define LOST_OFFSET         0.080f      // 横向偏差超过即判定丢线 (m)
+#define GYRO_NOISE_DPS      0.5f
+
+/* 与 LINE_TRACKER.c 保持一致 */
+#define SPEED_DROP_FACTOR   8
+#define MOTOR_DEAD_ZONE     18
+
+/* 合成前视: 与 UART.py LANE_ROWS / LINE_TRACKER.c Line_Lane_Preview 对应 */
+#define LANE_PERIOD_MS      33          // 摄像头帧间隔
+#define LANE_HALF_W         0.100f      // 前视距离处半幅画面对应的横向宽度 (m)
+#define LANE_OFFSET_W       2.0f        // 与 LINE_TRACKER.c 一致
+#define LANE_CURV_W         4.0f
+static const float lane_ahead[3] = { 0.15f, 0.25f, 0.35f };  // 近 / 中 / 远带到轴心的距离 (m)
+
+static const float sensor_y[4] = { 0.030f, 0.010f, -0.010f, -0.030f };  // L2 L1 R1 R2 (左为正)
+static const uint8_t sensor_bit[4] = { 0x08, 0x04, 0x02, 0x01 };
+
+/* 赛道：直线与圆弧拼接，预先离散成折线 */
+#define TRACK_STEP 0.005f
+#define TRACK_MAX  4096
+static float track_x[TRACK_MAX], track_y[TRACK_MAX];
+static int track_n;
+
+typedef struct { float length; float radius; int left; } SEG_T;   // radius<=0 为直线
+
+static const SEG_T track_segs[] = {
+    { 0.80f, 0, 0 },
+    { 0.55f, 0.35f, 1 },   // 左转约 90°
+    { 0.40f, 0, 0 },
+    { 1.10f, 0.35f, 0 },   // 右转约 180°
+    { 0.40f, 0, 0 },
+    { 0.55f, 0.35f, 1 },
+    { 0.30f, 0, 0 },
+    { 0.70f, 0.25f, 1 },   // 小半径左弯
+    { 0.80f, 0, 0 },
+};
+
+static void Track_Build(void)
+{
+    float x = 0, y = 0, th = 0;
+    track_n = 0;
+    for (size_t s = 0; s < sizeof(track_segs) / sizeof(track_segs[0]); s++)
+    {
+        int steps = (int)(track_segs[s].length / TRACK_STEP);
+        for (int i = 0; i < steps && track_n < TRACK_MAX; i++)
+        {
+            track_x[track_n] = x;
+            track_y[track_n] = y;
+            track_n++;
+            if (track_segs[s].radius > 0)
+                th += (track_segs[s].left ? 1.0f : -1.0f) * TRACK_STEP / track_segs[s].radius;
+            x += TRACK_STEP * cosf(th);
+            y += TRACK_STEP * sinf(th);
+        }
+    }
+}
+
+/* 点到赛道的有符号距离 (点在赛道左侧为正)，hint 为上次最近点下标 */
+static float Track_Offset(float px, float py, int *hint)
+{
+    int best = *hint;
+    float best_d2 = 1e9f;
+    int lo = *hint - 40 < 0 ? 0 : *hint - 40;
+    int hi = *hint + 80 >= track_n - 1 ? track_n - 2 : *hint + 80;
+    for (int i = lo; i <= hi; i++)
+    {
+        float dx = px - track_x[i], dy = py - track_y[i];
+        float d2 = dx * dx + dy * dy;
+        if (d2 < best_d2) { best_d2 = d2; best = i; }
+    }
+    *hint = best;
+    // 投影到 best -> best+1 线段的法向，得到连续的横向偏差
+    float tx = (track_x[best + 1] - track_x[best]) / TRACK_STEP;
+    float ty = (track_y[best + 1] - track_y[best]) / TRACK_STEP;
+    return tx * (py - track_y[best]) - ty * (px - track_x[best]);
+}
+
+/* ---------------- 与固件相同的误差映射 ---------------- */
+static float Sim_Line_Error(uint8_t sensor_state, float *last_valid_error)
+{
+    float e;
+    switch (sensor_state)
+    {
+        case 0x06: e = 0.0f; break;
+        case 0x09: e = 0.0f; break;
+        case 0x02: e = 1.0f; break;
+        case 0x03: e = 2.0f; break;
+        case 0x01: e = 3.0f; break;
+        case 0x07: e = 3.5f; break;
+        case 0x04: e = -1.0f; break;
+        case 0x0C: e = -2.0f; break;
+        case 0x08: e = -3.0f; break;
+        case 0x0E: e = -3.5f; break;
+        case 0x0F: e = 0.0f; break;
+        case 0x00:
+            if (*last_valid_error > 0) e = 4.0f;
+            else if (*last_valid_error < 0) e = -4.0f;
+            else e = 0.0f;
+            break;
+        default: e = *last_valid_error; break;
+    }
+    if (sensor_state != 0x00) *last_valid_error = e;
+    return e;
+}
+
+static int Sim_Dead_Zone(int speed)
+{
+    if (speed == 0) return 0;
+    if (speed > 0) { if (speed < MOTOR_DEAD_ZONE) return MOTOR_DEAD_ZONE; }
+    else { if (speed > -MOTOR_DEAD_ZONE) return -MOTOR_DEAD_ZONE; }
+    return speed;
+}
+
+static float Sim_Wheel_Target(int pwm)
+{
+    if (pwm > 100) pwm = 100;
+    if (pwm < -100) pwm = -100;
+    if (abs(pwm) < MOTOR_STICTION) return 0;
+    return V_MAX * (float)pwm / 100.0f;
+}
+
+static float Sim_Noise(void)
+{
+    // 近似高斯：12 个均匀分布求和
+    float s = 0;
+    for (int i = 0; i < 12; i++) s += (float)rand() / (float)RAND_MAX;
+    return s - 6.0f;
+}
+
+/*
+ * 合成一帧前视量 (误差单位，正数: 前方线在右侧)
+ * 三点在赛道左侧 (线在右侧) 时为正，归一化到半幅画面并按车道帧的精度 (1%) 取整
+ */
+static float Sim_Lane_Preview(float x, float y, float th, int hint)
+{
+    int xs[3];
+    for (int i = 0; i < 3; i++)
+    {
+        int h = hint;
+        float d = Track_Offset(x + lane_ahead[i] * cosf(th), y + lane_ahead[i] * sinf(th), &h) / LANE_HALF_W;
+        if (d > 0.99f) d = 0.99f;
+        if (d < -0.99f) d = -0.99f;
+        xs[i] = (int)(d * 100.0f);
+    }
+    int curv = xs[2] - 2 * xs[1] + xs[0];
+    if (curv > 99) curv = 99;
+    if (curv < -99) curv = -99;
+    return LANE_OFFSET_W * (float)xs[2] / 100.0f + LANE_CURV_W * (float)curv / 100.0f;
+}
+
+/* ---------------- 被比较的控制器 ---------------- */
+static const STEER_GAIN_T pd_gain[] = {
+    { 0, 5.0f, 0, 10.0f, 0, 0 },
+};
+static const STEER_CFG_T pd_cfg = { STEER_MODE_PD, pd_gain, 1, 0, 0, 0, 0, 100.0f };
+
+/* 与 LINE_TRACKER.c 中的 line_gain_schedule 保持一致 */
+static const STEER_GAIN_T sched_gain[] = {
+    /* speed   kp     ki     kd     kff    kpv  */
+    {  20.0f,  5.0f,  2.0f,  0.10f, 0.02f, 1.0f },
+    {  40.0f,  8.0f,  3.0f,  0.20f, 0.03f, 2.0f },
+    {  60.0f, 11.0f,  4.0f,  0.30f, 0.05f, 3.0f },
+};
+static const STEER_CFG_T sched_cfg = { STEER_MODE_SCHEDULED, sched_gain, 3, 15.0f, 2.0f, 8.0f, 3.0f, 100.0f };
+
+static const STEER_GAIN_T sched_noff_gain[] = {
+    {  20.0f,  5.0f,  2.0f,  0.10f, 0,     0 },
+    {  40.0f,  8.0f,  3.0f,  0.20f, 0,     0 },
+    {  60.0f, 11.0f,  4.0f,  0.30f, 0,     0 },
+};
+static const STEER_CFG_T sched_noff_cfg = { STEER_MODE_SCHEDULED, sched_noff_gain, 3, 15.0f, 2.0f, 8.0f, 3.0f, 100.0f };
+
+typedef struct { const char *name; const STEER_CFG_T *cfg; int preview; } CANDIDATE_T;
+
+/* 不带前视的候选不调用 Steer_Ctrl_Set_Preview，kpv 列不起作用 (与实车没有车道帧时相同) */
+static const CANDIDATE_T candidates[] = {
+    { "PD (legacy)",          &pd_cfg,         0 },
+    { "Scheduled PID",        &sched_noff_cfg, 0 },
+    { "Scheduled PID + FF",   &sched_cfg,      0 },
+    { "Sched + FF + preview", &sched_cfg,      1 },
+};
+
+/* ---------------- 单次仿真 ---------------- */
+typedef struct { int finished; float lap_time; float max_offset; } RESULT_T;
+
+static RESULT_T Sim_Run(const STEER_CFG_T *cfg, int preview, int max_base_speed, int verbose)
+{
+    STEER_CTRL_T ctrl;
+    RESULT_T res = { 0, 0, 0 };
+    float x = 0, y = 0, th = 0, vl = 0, vr = 0;
+    float last_valid_error = 0;
+    int pwm_l = 0, pwm_r = 0, hint = 0, ms = 0;
+
+    Steer_Ctrl_Init(&ctrl, cfg);
+    srand(1);
+
+    while (ms < 60000)
+    {
+        float omega = (vr - vl) / WHEEL_BASE;
+
+        if (ms % CTRL_PERIOD_MS == 0)
+        {
+            uint8_t state = 0;
+            float sx = x + SENSOR_AHEAD * cosf(th), sy = y + SENSOR_AHEAD * sinf(th);
+            int h2 = hint;
+            for (int i = 0; i < 4; i++)
+            {
+                float px = sx - sensor_y[i] * sinf(th), py = sy + sensor_y[i] * cosf(th);
+                if (fabsf(Track_Offset(px, py, &h2)) < SENSOR_ACTIVE_HALF) state |= sensor_bit[i];
+            }
+
+            float error = Sim_Line_Error(state, &last_valid_error);
+            int base = max_base_speed - (int)(fabsf(error) * SPEED_DROP_FACTOR);
+            if (base < 0) base = 0;
+            float yaw_dps = omega * 57.2958f + GYRO_NOISE_DPS * Sim_Noise();
+            if (preview && ms % LANE_PERIOD_MS < CTRL_PERIOD_MS)
+            {
+                Steer_Ctrl_Set_Preview(&ctrl, Sim_Lane_Preview(x, y, th, hint));
+            }
+            PROF_BEGIN(PROF_STEER_UPDATE);
+            float out = Steer_Ctrl_Update(&ctrl, error, (float)base, yaw_dps, CTRL_PERIOD_MS / 1000.0f);
+            PROF_END(PROF_STEER_UPDATE);
+            pwm_l = Sim_Dead_Zone(base + (int)out);
+            pwm_r = Sim_Dead_Zone(base - (int)out);
+
+            if (verbose)
+                printf("%6d ms  state=%X  err=%+4.1f  pv=%+5.2f  out=%+6.1f (pv %+5.1f i %+5.1f)  L=%4d R=%4d  offset=%+6.1f mm\n",
+                       ms, state, error, ctrl.preview, out, ctrl.pv_term, ctrl.integral, pwm_l, pwm_r,
+                       1000.0f * Track_Offset(x, y, &h2));
+        }
+
+        vl += (Sim_Wheel_Target(pwm_l) - vl) * SIM_DT / MOTOR_TAU;
+        vr += (Sim_Wheel_Target(pwm_r) - vr) * SIM_DT / MOTOR_TAU;
+        float v = 0.5f * (vl + vr);
+        x += v * cosf(th) * SIM_DT;
+        y += v * sinf(th) * SIM_DT;
+        th += omega * SIM_DT;
+        ms++;
+
+        float off = fabsf(Track_Offset(x, y, &hint));
+        if (off > res.max_offset) res.max_offset = off;
+        if (off > LOST_OFFSET) break;
+        if (hint >= track_n - 3)
+        {
+            res.finished = 1;
+            break;
+        }
+    }
+    res.lap_time = ms / 1000.0f;
+    return res;
+}
+
+#ifdef PROFILE_HOST
+static void Sim_Print_Profile(void)
+{
+    static char report[1024];
+    Profile_Format(report, sizeof(report));
+    printf("\n%s", report);
+}
+#else
+#define Sim_Print_Profile()
+#endif
+
+int main(int argc, char **argv)
+{
+    Track_Build();
+#ifdef PROFILE_HOST
+    Profile_Init();
+#endif
+
+    if (argc >= 3 && strcmp(argv[1], "-v") == 0)
+    {
+        int speed = atoi(argv[2]);
+        for (size_t c = 0; c < sizeof(candidates) / sizeof(candidates[0]); c++)
+        {
+            printf("==== %s @ %d ====\n", candidates[c].name, speed);
+            RESULT_T r = Sim_Run(candidates[c].cfg, candidates[c].preview, speed, 1);
+            printf("finished=%d lap=%.2fs max_offset=%.1fmm\n", r.finished, r.lap_time, r.max_offset * 1000.0f);
+        }
+        Sim_Print_Profile();
+        return 0;
+    }
+
+    printf("track length %.2f m\n\n", track_n * TRACK_STEP);
+    printf("%-22s %10s %10s %10s %12s\n", "controller", "held", "lost at", "lap(s)", "offset(mm)");
+    for (size_t c = 0; c < sizeof(candidates) / sizeof(candidates[0]); c++)
+    {
+        int held = 0, lost = 0;
+        RESULT_T best = { 0, 0, 0 };
+        for (int speed = 10; speed <= 100; speed += 2)
+        {
+            RESULT_T r = Sim_Run(candidates[c].cfg, candidates[c].preview, speed, 0);
+            if (!r.finished)
+            {
+                lost = speed;
+                break;
+            }
+            held = speed;
+            best = r;
+        }
+        if (lost)
+            printf("%-22s %10d %10d %10.2f %12.1f\n", candidates[c].name, held, lost, best.lap_time, best.max_offset * 1000.0f);
+        else
+            printf("%-22s %10d %10s %10.2f %12.1f\n", candidates[c].name, held, "-", best.lap_time, best.max_offset * 1000.0f);
+    }
+    Sim_Print_Profile();
+    return 0;
+}
@@ -0,0 +1,287 @@
+"""
+遥测记录解码 (Hardware/TELEMETRY.h)
+
+    python Tools/tlm_decode.py dump.bin -o run.csv            # 解码抓包文件
+    python Tools/tlm_decode.py --port COM5 -o run.csv         # 直接从串口读取，Ctrl+C 结束
+    python Tools/tlm_decode.py dump.bin -o run.csv --plot     # 同时画出误差/输出/轮速曲线
+
+控制周期记录写入 run.csv，运行监控的任务/系统统计 (Hardware/MONITOR.c) 写入
+run_tasks.csv / run_sys.csv，结束时打印最后一次的任务统计表。
+
+每条记录 32 字节: 0xA5 起始，最后一字节为前 31 字节的异或。
+校验失败时向后滑动 1 字节重新同步，夹杂的其他数据会被跳过；
+其中以 "PROF" 开头的文本行 (Hardware/PROFILE.c 的耗时报告)、以 "AVOID" 开头的
+文本行 (Hardware/Avoid.c 的绕行报告) 和以 "RECOVER" 开头的文本行 (Hardware/RECOVER.c
+的找线报告) 原样打印出来。
+"""
+import argparse
+import csv
+import struct
+import sys
+
+SYNC = 0xA5
+RECORD_SIZE = 32
+TYPE_TICK = 0x01
+TYPE_TASK = 0x10
+TYPE_SYS = 0x11
+TYPE_PANIC = 0xEE
+TYPES = (TYPE_TICK, TYPE_TASK, TYPE_SYS, TYPE_PANIC)
+
+TICK_FMT = struct.Struct("<BBHIhhbbBBhHhhhhHbB")
+TASK_FMT = struct.Struct("<BBHI10sHHBBBB5sB")
+SYS_FMT = struct.Struct("<BBHIIIHBB4s4s3sB")
+PANIC_FMT = struct.Struct("<BBHIIIIIIB2sB")
+
+STATES = {0: "TRACK", 1: "JUNCTION", 2: "BLIND_TURN", 3: "AVOID", 4: "RECOVER"}
+TASK_STATES = {0: "Running", 1: "Ready", 2: "Blocked", 3: "Suspended", 4: "Deleted"}
+PANIC_REASONS = {1: "HardFault", 2: "StackOverflow", 3: "MallocFailed"}
+QUEUES = ("SG90Queue", "MVQueue", "MotorQueue", "OLEDQueue")
+MON_FLAG_STACK_LOW = 0x01
+
+CSV_FIELDS = ["seq", "time_ms", "state", "sensor", "error", "output",
+              "left", "right", "yaw_rate_dps", "distance_cm",
+              "p_term", "i_term", "d_term", "ff_term", "pv_term", "latency_us"]
+TASK_FIELDS = ["time_ms", "number", "name", "cpu_pct", "stack_free_words",
+               "priority", "state", "stack_low"]
+SYS_FIELDS = ["time_ms", "heap_free", "heap_min", "idle_pct", "task_count", "stack_warn"] + \
+             ["%s_used" % q for q in QUEUES] + ["%s_size" % q for q in QUEUES]
+
+
+def checksum_ok(frame):
+    x = 0
+    for b in frame[:RECORD_SIZE - 1]:
+        x ^= b
+    return x == frame[RECORD_SIZE - 1]
+
+
+def decode_tick(frame):
+    (_, _, seq, time_ms, error, output, left, right, sensor, state,
+     yaw_rate, distance, p_term, i_term, d_term, ff_term, latency, pv_term, _) = TICK_FMT.unpack(frame)
+    return {
+        "seq": seq,
+        "time_ms": time_ms,
+        "state": STATES.get(state, str(state)),
+        "sensor": format(sensor, "04b"),
+        "error": error / 100.0,
+        "output": output / 10.0,
+        "left": left,
+        "right": right,
+        "yaw_rate_dps": yaw_rate / 10.0,
+        "distance_cm": "" if distance == 0xFFFF else distance / 10.0,
+        "p_term": p_term / 10.0,
+        "i_term": i_term / 10.0,
+        "d_term": d_term / 10.0,
+        "ff_term": ff_term / 10.0,
+        "pv_term": pv_term,
+        "latency_us": latency,
+    }
+
+
+def decode_task(frame):
+    _, _, _, time_ms, name, cpu, stack_free, prio, state, number, flags, _, _ = TASK_FMT.unpack(frame)
+    return {
+        "time_ms": time_ms,
+        "number": number,
+        "name": name.split(b"\0", 1)[0].decode("ascii", "replace"),
+        "cpu_pct": cpu / 10.0,
+        "stack_free_words": stack_free,
+        "priority": prio,
+        "state": TASK_STATES.get(state, str(state)),
+        "stack_low": 1 if flags & MON_FLAG_STACK_LOW else 0,
+    }
+
+
+def decode_sys(frame):
+    _, _, _, time_ms, heap_free, heap_min, idle, task_count, warn, used, size, _, _ = SYS_FMT.unpack(frame)
+    rec = {"time_ms": time_ms, "heap_free": heap_free, "heap_min": heap_min,
+           "idle_pct": idle / 10.0, "task_count": task_count, "stack_warn": warn}
+    for i, q in enumerate(QUEUES):
+        rec["%s_used" % q] = used[i]
+        rec["%s_size" % q] = size[i]
+    return rec
+
+
+def decode_panic(frame):
+    _, _, seq, time_ms, cfsr, hfsr, mmfar, bfar, head, reason, _, _ = PANIC_FMT.unpack(frame)
+    return {"seq": seq, "time_ms": time_ms, "cfsr": cfsr, "hfsr": hfsr,
+            "mmfar": mmfar, "bfar": bfar, "head": head,
+            "reason": PANIC_REASONS.get(reason, str(reason))}
+
+
+class Decoder:
+    """字节流 -> 记录，可以分多次喂数据"""
+
+    def __init__(self):
+        self.buf = bytearray()
+        self.skipped = 0
+        self.lost = 0
+        self.last_seq = None
+        self.text = bytearray()
+
+    def _skip(self, b):
+        self.skipped += 1
+        if b == 0x0A:
+            line = self.text.decode("ascii", "replace").strip()
+            self.text.clear()
+            if line.startswith(("PROF", "AVOID", "RECOVER")):
+                return line
+        elif len(self.text) < 256:
+            self.text.append(b)
+        return None
+
+    def feed(self, data):
+        self.buf += data
+        out = []
+        i = 0
+        while len(self.buf) - i >= RECORD_SIZE:
+            frame = bytes(self.buf[i:i + RECORD_SIZE])
+            if frame[0] != SYNC or frame[1] not in TYPES or not checksum_ok(frame):
+                line = self._skip(frame[0])
+                if line:
+                    out.append(("text", line))
+                i += 1
+                continue
+            self.text.clear()
+            i += RECORD_SIZE
+            if frame[1] == TYPE_PANIC:
+                # 崩溃转储之后的记录是历史数据，序号重新开始计算
+                self.last_seq = None
+                out.append(("panic", decode_panic(frame)))
+                continue
+            if frame[1] == TYPE_TASK:
+                out.append(("task", decode_task(frame)))
+                continue
+            if frame[1] == TYPE_SYS:
+                out.append(("sys", decode_sys(frame)))
+                continue
+            rec = decode_tick(frame)
+            if self.last_seq is not None:
+                gap = (rec["seq"] - self.last_seq - 1) & 0xFFFF
+                if gap < 0x8000:
+                    self.lost += gap
+            self.last_seq = rec["seq"]
+            out.append(("tick", rec))
+        del self.buf[:i]
+        return out
+
+    def flush(self):
+        """数据结束时处理不足一条记录的尾部 (只可能是文本)"""
+        out = []
+        for b in self.buf:
+            line = self._skip(b)
+            if line:
+                out.append(("text", line))
+        self.buf.clear()
+        return out
+
+
+def read_chunks(args):
+    if args.port:
+        import serial  # pyserial
+        with serial.Serial(args.port, args.baud, timeout=0.2) as ser:
+            try:
+                while True:
+                    data = ser.read(4096)
+                    if data:
+                        yield data
+            except KeyboardInterrupt:
+                return
+    else:
+        with open(args.input, "rb") as f:
+            while True:
+                data = f.read(65536)
+                if not data:
+                    return
+                yield data
+
+
+def decode_stream(dec, args):
+    for chunk in read_chunks(args):
+        yield from dec.feed(chunk)
+    yield from dec.flush()
+
+
+def plot(rows, path):
+    import matplotlib.pyplot as plt
+
+    t = [(r["time_ms"] - rows[0]["time_ms"]) / 1000.0 for r in rows]
+    fig, ax = plt.subplots(3, 1, sharex=True, figsize=(10, 7))
+    ax[0].step(t, [r["error"] for r in rows], where="post", label="error")
+    ax[0].legend(loc="upper right")
+    for key in ("output", "p_term", "i_term", "d_term", "ff_term", "pv_term"):
+        ax[1].plot(t, [r[key] for r in rows], label=key)
+    ax[1].legend(loc="upper right")
+    ax[2].plot(t, [r["left"] for r in rows], label="left")
+    ax[2].plot(t, [r["right"] for r in rows], label="right")
+    ax[2].plot(t, [r["yaw_rate_dps"] for r in rows], label="yaw rate (deg/s)")
+    ax[2].legend(loc="upper right")
+    ax[2].set_xlabel("t (s)")
+    fig.tight_layout()
+    fig.savefig(path)
+    print("plot saved to", path)
+
+
+def main():
+    ap = argparse.ArgumentParser(description="decode STM32 telemetry records")
+    ap.add_argument("input", nargs="?", help="raw capture file")
+    ap.add_argument("--port", help="read from serial port instead of file")
+    ap.add_argument("--baud", type=int, default=115200)
+    ap.add_argument("-o", "--output", default="telemetry.csv")
+    ap.add_argument("--plot", action="store_true", help="save <output>.png")
+    args = ap.parse_args()
+    if not args.input and not args.port:
+        ap.error("need a capture file or --port")
+
+    base = args.output.rsplit(".", 1)[0]
+    dec = Decoder()
+    rows = []
+    tasks = {}
+    last_sys = None
+    with open(args.output, "w", newline="") as f, \
+            open(base + "_tasks.csv", "w", newline="") as ft, \
+            open(base + "_sys.csv", "w", newline="") as fs:
+        writer = csv.DictWriter(f, fieldnames=CSV_FIELDS)
+        task_writer = csv.DictWriter(ft, fieldnames=TASK_FIELDS)
+        sys_writer = csv.DictWriter(fs, fieldnames=SYS_FIELDS)
+        for w in (writer, task_writer, sys_writer):
+            w.writeheader()
+        for kind, rec in decode_stream(dec, args):
+            if kind == "text":
+                print(rec)
+            elif kind == "panic":
+                print("PANIC (%s) at %d ms: CFSR=%08X HFSR=%08X MMFAR=%08X BFAR=%08X (last seq %d)"
+                      % (rec["reason"], rec["time_ms"], rec["cfsr"], rec["hfsr"], rec["mmfar"], rec["bfar"], rec["seq"]),
+                      file=sys.stderr)
+            elif kind == "task":
+                task_writer.writerow(rec)
+                if rec["stack_low"] and not tasks.get(rec["name"], {}).get("stack_low"):
+                    print("WARN %d ms: task %s stack low, %d words left"
+                          % (rec["time_ms"], rec["name"], rec["stack_free_words"]), file=sys.stderr)
+                tasks[rec["name"]] = rec
+            elif kind == "sys":
+                sys_writer.writerow(rec)
+                last_sys = rec
+            else:
+                writer.writerow(rec)
+                rows.append(rec)
+
+    print("%d records, %d lost, %d bytes skipped -> %s" % (len(rows), dec.lost, dec.skipped, args.output))
+    lat = sorted(r["latency_us"] for r in rows if r["latency_us"])
+    if lat:
+        print("sensor->motor latency: mean %d us, p99 %d us, max %d us"
+              % (sum(lat) // len(lat), lat[min(len(lat) - 1, len(lat) * 99 // 100)], lat[-1]))
+    if tasks:
+        print("\n%-12s %4s %8s %12s %10s" % ("task", "prio", "cpu(%)", "stack free", "state"))
+        for t in sorted(tasks.values(), key=lambda t: -t["priority"]):
+            print("%-12s %4d %8.1f %12d %10s" % (t["name"], t["priority"], t["cpu_pct"],
+                                                 t["stack_free_words"], t["state"]))
+    if last_sys:
+        print("heap free %d B (min ever %d B), idle %.1f%%, queues %s" % (
+            last_sys["heap_free"], last_sys["heap_min"], last_sys["idle_pct"],
+            " ".join("%s %d/%d" % (q, last_sys["%s_used" % q], last_sys["%s_size" % q]) for q in QUEUES)))
+    if args.plot and rows:
+        plot(rows, args.output.rsplit(".", 1)[0] + ".png")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,307 @@
+"""
+调度跟踪快照分析 (Hardware/TRACE.h)
+
+    python Tools/trace_timeline.py dump.bin                 # 分析抓包文件中的全部快照
+    python Tools/trace_timeline.py --port COM5              # 从串口等待下一次快照
+    python Tools/trace_timeline.py dump.bin --csv seg.csv --plot
+
+快照由循迹控制周期超时 (TRACE_LATE_TICK_MS) 触发，经 USART2 整块发出，
+可以和遥测记录混在同一个抓包文件里，这里只按 "TRC1" ... "TRCE" 把它挑出来。
+
+对每个任务，一次 "作业" 从进入就绪态 (TASK_READY) 开始，到它下一次进入就绪态之前
+最后一次被切出 (TASK_OUT) 为止:
+    延迟 = 第一次切入 - 就绪          响应时间 = 最后一次切出 - 就绪
+最坏响应时间 (WCRT) 取快照内所有完整作业的最大值。
+"""
+import argparse
+import csv
+import struct
+import sys
+
+HDR_FMT = struct.Struct("<4sHBBII")
+NAME_FMT = struct.Struct("<BB14s")
+EVENT_FMT = struct.Struct("<IBBH")
+TAIL_FMT = struct.Struct("<4sI")
+
+EV_TASK_IN = 0x01
+EV_TASK_OUT = 0x02
+EV_TASK_READY = 0x03
+EV_ISR_ENTER = 0x10
+EV_ISR_EXIT = 0x11
+EV_QUEUE_SEND = 0x20
+EV_QUEUE_RECV = 0x21
+EV_QUEUE_BLOCK = 0x22
+EV_QUEUE_FULL = 0x23
+EV_MARK = 0x30
+EV_TRIGGER = 0xF0
+
+NAME_TASK, NAME_QUEUE, NAME_ISR, NAME_MARK = range(4)
+TRIGGERS = {1: "LATE_TICK", 2: "MANUAL"}
+
+
+class Dump:
+    def __init__(self, hdr, names, events):
+        self.count, self.name_count, self.cause, self.cpu_hz, self.dropped = hdr
+        self.names = names        # (kind, id) -> name
+        self.events = events      # [(cycles, type, id, arg)]，cycles 已展开为单调递增
+
+    def name(self, kind, ident):
+        return self.names.get((kind, ident), "%s%d" % ("task queue isr mark".split()[kind], ident))
+
+    def us(self, cycles):
+        return cycles * 1e6 / self.cpu_hz
+
+
+def parse_dumps(data):
+    """在字节流中查找完整的快照，校验失败的跳过"""
+    dumps = []
+    pos = 0
+    while True:
+        pos = data.find(b"TRC1", pos)
+        if pos < 0 or len(data) - pos < HDR_FMT.size:
+            return dumps, pos if pos >= 0 else len(data)
+        _, count, name_count, cause, cpu_hz, dropped = HDR_FMT.unpack_from(data, pos)
+        names_at = pos + HDR_FMT.size
+        events_at = names_at + name_count * NAME_FMT.size
+        tail_at = events_at + count * EVENT_FMT.size
+        if len(data) < tail_at + TAIL_FMT.size:
+            return dumps, pos       # 不完整，等更多数据
+        magic, checksum = TAIL_FMT.unpack_from(data, tail_at)
+        words = struct.unpack_from("<%dI" % (count * 2), data, events_at)
+        if magic != b"TRCE" or sum(words) & 0xFFFFFFFF != checksum or cpu_hz == 0:
+            print("skip corrupt trace block at byte %d" % pos, file=sys.stderr)
+            pos += 4
+            continue
+
+        names = {}
+        for i in range(name_count):
+            kind, ident, name = NAME_FMT.unpack_from(data, names_at + i * NAME_FMT.size)
+            names[(kind, ident)] = name.split(b"\0", 1)[0].decode("ascii", "replace")
+
+        events = []
+        t = 0
+        prev = None
+        for i in range(count):
+            stamp, etype, ident, arg = EVENT_FMT.unpack_from(data, events_at + i * EVENT_FMT.size)
+            if prev is not None:
+                t += (stamp - prev) & 0xFFFFFFFF    # DWT 计数 32 位回绕
+            prev = stamp
+            events.append((t, etype, ident, arg))
+        dumps.append(Dump((count, name_count, cause, cpu_hz, dropped), names, events))
+        pos = tail_at + TAIL_FMT.size
+
+
+class Stat:
+    def __init__(self):
+        self.values = []
+
+    def add(self, v):
+        self.values.append(v)
+
+    def max(self):
+        return max(self.values) if self.values else 0.0
+
+    def mean(self):
+        return sum(self.values) / len(self.values) if self.values else 0.0
+
+
+class TaskStat:
+    def __init__(self):
+        self.latency = Stat()
+        self.response = Stat()
+        self.exec_time = 0
+        self.preempted = 0
+        self.release = None     # 当前作业就绪时刻
+        self.start = None       # 当前作业第一次切入时刻
+        self.last_out = None
+        self.switched_out = False
+
+
+def analyze(dump):
+    tasks = {}
+    isr = {}
+    isr_stack = []
+    marks = {}
+    queues = {}
+    segments = []           # (kind, id, start, end)，单位 cycles
+    running = None
+    seg_start = None
+    trigger = None
+
+    def task(ident):
+        return tasks.setdefault(ident, TaskStat())
+
+    for t, etype, ident, arg in dump.events:
+        if etype == EV_TASK_READY:
+            ts = task(ident)
+            # 上一个作业在最后一次切出时结束
+            if ts.release is not None and ts.start is not None and ts.last_out is not None \
+                    and ts.last_out >= ts.start:
+                ts.response.add(ts.last_out - ts.release)
+            if ts.release is None or ts.start is not None:
+                ts.release = t
+                ts.start = None
+            ts.switched_out = False
+        elif etype == EV_TASK_IN:
+            ts = task(ident)
+            if ts.release is not None and ts.start is None:
+                ts.start = t
+                ts.latency.add(t - ts.release)
+            elif ts.switched_out and ts.start is not None:
+                ts.preempted += 1   # 切出后没有重新就绪就又切入: 被抢占
+            ts.switched_out = False
+            running, seg_start = ident, t
+        elif etype == EV_TASK_OUT:
+            ts = task(ident)
+            if running == ident and seg_start is not None:
+                ts.exec_time += t - seg_start
+                segments.append((NAME_TASK, ident, seg_start, t))
+            ts.last_out = t
+            ts.switched_out = True
+            running, seg_start = None, None
+        elif etype == EV_ISR_ENTER:
+            isr_stack.append((ident, t))
+        elif etype == EV_ISR_EXIT:
+            # 从栈顶找对应的入口 (嵌套中断)
+            for k in range(len(isr_stack) - 1, -1, -1):
+                if isr_stack[k][0] == ident:
+                    start = isr_stack.pop(k)[1]
+                    isr.setdefault(ident, Stat()).add(t - start)
+                    segments.append((NAME_ISR, ident, start, t))
+                    break
+        elif etype in (EV_QUEUE_SEND, EV_QUEUE_RECV, EV_QUEUE_BLOCK, EV_QUEUE_FULL):
+            q = queues.setdefault(ident, {"send": 0, "recv": 0, "block": 0, "full": 0, "depth": 0})
+            key = {EV_QUEUE_SEND: "send", EV_QUEUE_RECV: "recv",
+                   EV_QUEUE_BLOCK: "block", EV_QUEUE_FULL: "full"}[etype]
+            q[key] += 1
+            depth = arg + 1 if etype == EV_QUEUE_SEND else arg
+            q["depth"] = max(q["depth"], depth)
+        elif etype == EV_MARK:
+            m = marks.setdefault(ident, {"last": None, "period": Stat(), "worst_at": 0})
+            if m["last"] is not None:
+                period = t - m["last"]
+                if period > m["period"].max():
+                    m["worst_at"] = m["last"]
+                m["period"].add(period)
+            m["last"] = t
+        elif etype == EV_TRIGGER:
+            trigger = t
+
+    return {"tasks": tasks, "isr": isr, "marks": marks, "queues": queues,
+            "segments": segments, "trigger": trigger}
+
+
+def report(n, dump, res):
+    span = dump.events[-1][0] if dump.events else 0
+    us = dump.us
+    trig = "" if res["trigger"] is None else ", trigger %s at %.1f us" % (
+        TRIGGERS.get(dump.cause, str(dump.cause)), us(res["trigger"]))
+    print("\n=== trace %d: %d events over %.1f us (%d overwritten), CPU %.0f MHz%s ===" % (
+        n, dump.count, us(span), dump.dropped, dump.cpu_hz / 1e6, trig))
+
+    print("%-16s %5s %7s %10s %10s %10s %10s %8s" % (
+        "task", "jobs", "cpu(%)", "lat max", "lat mean", "WCRT", "resp mean", "preempt"))
+    rows = sorted(res["tasks"].items(), key=lambda kv: -kv[1].response.max())
+    for ident, ts in rows:
+        print("%-16s %5d %7.1f %10.1f %10.1f %10.1f %10.1f %8d" % (
+            dump.name(NAME_TASK, ident), len(ts.response.values),
+            100.0 * ts.exec_time / span if span else 0.0,
+            us(ts.latency.max()), us(ts.latency.mean()),
+            us(ts.response.max()), us(ts.response.mean()), ts.preempted))
+    print("(us; WCRT / resp: ready -> last switch-out of the same job)")
+
+    if res["isr"]:
+        print("%-16s %5s %10s %10s" % ("isr", "n", "max(us)", "mean(us)"))
+        for ident, st in sorted(res["isr"].items()):
+            print("%-16s %5d %10.2f %10.2f" % (dump.name(NAME_ISR, ident), len(st.values),
+                                               us(st.max()), us(st.mean())))
+    for ident, m in sorted(res["marks"].items()):
+        p = m["period"]
+        if p.values:
+            print("mark %-11s n=%d period min %.1f mean %.1f max %.1f us (worst starts at %.1f us)" % (
+                dump.name(NAME_MARK, ident), len(p.values) + 1, us(min(p.values)),
+                us(p.mean()), us(p.max()), us(m["worst_at"])))
+    for ident, q in sorted(res["queues"].items()):
+        print("queue %-10s send %d recv %d block %d full %d max depth %d" % (
+            dump.name(NAME_QUEUE, ident), q["send"], q["recv"], q["block"], q["full"], q["depth"]))
+
+
+def write_csv(path, dumps_results):
+    with open(path, "w", newline="") as f:
+        w = csv.writer(f)
+        w.writerow(["trace", "kind", "name", "start_us", "end_us"])
+        for n, (dump, res) in enumerate(dumps_results, 1):
+            for kind, ident, start, end in res["segments"]:
+                w.writerow([n, "task" if kind == NAME_TASK else "isr", dump.name(kind, ident),
+                            "%.2f" % dump.us(start), "%.2f" % dump.us(end)])
+    print("segments saved to", path)
+
+
+def plot(path, dump, res):
+    import matplotlib.pyplot as plt
+
+    rows = sorted({(k, i) for k, i, _, _ in res["segments"]}, key=lambda r: (r[0], r[1]))
+    index = {r: n for n, r in enumerate(rows)}
+    fig, ax = plt.subplots(figsize=(14, 0.4 * len(rows) + 1.5))
+    for kind, ident, start, end in res["segments"]:
+        ax.broken_barh([(dump.us(start), max(dump.us(end - start), 0.5))], (index[(kind, ident)] - 0.4, 0.8),
+                       color="tab:blue" if kind == NAME_TASK else "tab:orange")
+    for t, etype, ident, _ in dump.events:
+        if etype == EV_MARK:
+            ax.axvline(dump.us(t), color="tab:green", linewidth=0.5)
+    if res["trigger"] is not None:
+        ax.axvline(dump.us(res["trigger"]), color="tab:red", linewidth=1.5, label="trigger")
+        ax.legend(loc="upper right")
+    ax.set_yticks(range(len(rows)))
+    ax.set_yticklabels([dump.name(k, i) for k, i in rows])
+    ax.set_xlabel("t (us)")
+    fig.tight_layout()
+    fig.savefig(path)
+    print("plot saved to", path)
+
+
+def read_input(args):
+    if not args.port:
+        with open(args.input, "rb") as f:
+            return parse_dumps(f.read())[0]
+    import serial  # pyserial
+    buf = bytearray()
+    with serial.Serial(args.port, args.baud, timeout=0.2) as ser:
+        print("waiting for trace snapshot on %s ..." % args.port)
+        try:
+            while True:
+                buf += ser.read(4096)
+                dumps, keep = parse_dumps(bytes(buf))
+                if dumps:
+                    return dumps
+                del buf[:min(keep, max(0, len(buf) - 3))]   # 保留可能不完整的 "TRC1"
+        except KeyboardInterrupt:
+            return []
+
+
+def main():
+    ap = argparse.ArgumentParser(description="reconstruct task timeline from STM32 trace snapshots")
+    ap.add_argument("input", nargs="?", help="raw capture file")
+    ap.add_argument("--port", help="read from serial port instead of file")
+    ap.add_argument("--baud", type=int, default=115200)
+    ap.add_argument("--csv", help="save task/ISR execution segments")
+    ap.add_argument("--plot", action="store_true", help="save trace_<n>.png timeline per snapshot")
+    args = ap.parse_args()
+    if not args.input and not args.port:
+        ap.error("need a capture file or --port")
+
+    dumps = read_input(args)
+    if not dumps:
+        print("no complete trace snapshot found")
+        return
+    results = [(d, analyze(d)) for d in dumps]
+    for n, (dump, res) in enumerate(results, 1):
+        report(n, dump, res)
+        if args.plot:
+            plot("trace_%d.png" % n, dump, res)
+    if args.csv:
+        write_csv(args.csv, results)
+
+
+if __name__ == "__main__":
+    main()